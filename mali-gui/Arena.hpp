@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace maligui
+{
+
+/**
+ * @brief The Arena class is a bump allocator for the objects of a single
+ * screen. Allocations only advance a pointer within the arena buffer, and are
+ * never freed on their own. All the memory is released at once, when the arena
+ * is reset or destroyed, e.g. when the screen is popped from the Stacker.
+ *
+ * Widgets are created in the arena with make(), which passes the arena to
+ * their constructor. Their children, and the click handlers bound with bind(),
+ * are then allocated from the same arena, so building a screen does not touch
+ * the heap (apart from the widgets' own members, such as texts).
+ *
+ * Widgets made in the arena must be destroyed before the arena itself. The
+ * callables bound to the arena are destroyed by the arena, when it is reset or
+ * destroyed.
+ */
+class Arena
+{
+public:
+	template<typename TCallable>
+	/**
+	 * @brief Callable stored in the arena. Holds a single pointer, so it fits
+	 * any Delegate, however large the stored callable is.
+	 */
+	class Bound
+	{
+	public:
+		explicit Bound(TCallable *callable) : mCallable(callable)
+		{
+		}
+
+		template<typename ... TArgs>
+		auto operator() (TArgs && ... args) const
+		-> decltype(std::declval<TCallable &>()(std::forward<TArgs>(args) ...))
+		{
+			return (*mCallable)(std::forward<TArgs>(args) ...);
+		}
+
+	private:
+		TCallable *mCallable;
+	};
+
+	/**
+	 * @brief Creates an arena with a buffer of the given size, allocated once
+	 * from the heap.
+	 */
+	explicit Arena(size_t capacity) :
+		mOwned(new uint8_t[capacity]),
+		mBuffer(mOwned.get()),
+		mCapacity(capacity)
+	{
+	}
+
+	/**
+	 * @brief Creates an arena in the given buffer (e.g. a static array), so
+	 * that the heap is not used at all.
+	 */
+	Arena(void *buffer, size_t capacity) :
+		mBuffer(static_cast<uint8_t *>(buffer)),
+		mCapacity(capacity)
+	{
+	}
+
+	Arena(const Arena &) = delete;
+	Arena &operator= (const Arena &) = delete;
+
+	~Arena()
+	{
+		finalize();
+	}
+
+	/**
+	 * @brief Allocates a block from the arena.
+	 * @throws std::bad_alloc if the arena is full.
+	 */
+	void *allocate (size_t size, size_t alignment = alignof(std::max_align_t))
+	{
+		uintptr_t base  = reinterpret_cast<uintptr_t>(mBuffer);
+		size_t    start = (base + mUsed + alignment - 1) / alignment * alignment - base;
+
+		if (start > mCapacity || size > mCapacity - start) {
+			throw std::bad_alloc();
+		}
+
+		mUsed = start + size;
+
+		return mBuffer + start;
+	}
+
+	/**
+	 * @brief Releases all the allocations at once, destroying the bound
+	 * callables. Widgets made in the arena must have been destroyed.
+	 */
+	inline void reset ()
+	{
+		finalize();
+		mUsed = 0;
+	}
+
+	inline size_t used () const
+	{
+		return mUsed;
+	}
+
+	inline size_t capacity () const
+	{
+		return mCapacity;
+	}
+
+	/**
+	 * @brief Creates a widget in the arena. The arena is passed as the first
+	 * argument of the constructor, if the widget accepts it. Deleting the
+	 * widget runs its destructor, but leaves the memory to the arena.
+	 */
+	template<typename TWidget, typename ... TArgs>
+	std::unique_ptr<TWidget> make (TArgs && ... args)
+	{
+		static_assert(std::has_virtual_destructor<TWidget>::value,
+		              "Widget made in an arena must have a virtual destructor");
+
+		void *block = allocate(sizeof(Owned<TWidget>), alignof(Owned<TWidget>));
+
+		return std::unique_ptr<TWidget>(
+			construct<TWidget>(block, std::is_constructible<TWidget, Arena *, TArgs ...>(),
+			                   std::forward<TArgs>(args) ...));
+	}
+
+	/**
+	 * @brief Moves the callable (e.g. a click handler) into the arena. Unless
+	 * trivially destructible, the callable is destroyed by the arena, once it
+	 * is reset or destroyed.
+	 * @return Callable forwarding the calls to the stored one.
+	 */
+	template<typename TCallable>
+	Bound<TCallable> bind (TCallable callable)
+	{
+		void *block = allocate(sizeof(TCallable), alignof(TCallable));
+		TCallable *stored = new (block) TCallable(std::move(callable));
+
+		if (!std::is_trivially_destructible<TCallable>::value) {
+			void *node = allocate(sizeof(Finalizer), alignof(Finalizer));
+
+			mFinalizers = new (node) Finalizer { &destroy<TCallable>, stored, mFinalizers };
+		}
+
+		return Bound<TCallable>(stored);
+	}
+
+private:
+	template<typename TWidget>
+	/**
+	 * @brief Widget made in the arena. Its memory is released with the arena,
+	 * so deleting it only runs the destructors.
+	 */
+	class Owned final : public TWidget
+	{
+	public:
+		template<typename ... TArgs>
+		Owned(TArgs && ... args) : TWidget(std::forward<TArgs>(args) ...)
+		{
+		}
+
+		static void operator delete (void *)
+		{
+		}
+	};
+
+	/**
+	 * @brief Destructor of a bound callable, to run as the arena is released.
+	 * Finalizers are kept in the arena, the last bound first.
+	 */
+	struct Finalizer
+	{
+		void (*destroy)(void *);
+		void *object;
+		Finalizer *next;
+	};
+
+	template<typename TWidget, typename ... TArgs>
+	Owned<TWidget> *construct (void *block, std::true_type, TArgs && ... args)
+	{
+		return new (block) Owned<TWidget>(this, std::forward<TArgs>(args) ...);
+	}
+
+	template<typename TWidget, typename ... TArgs>
+	Owned<TWidget> *construct (void *block, std::false_type, TArgs && ... args)
+	{
+		return new (block) Owned<TWidget>(std::forward<TArgs>(args) ...);
+	}
+
+	template<typename TCallable>
+	static void destroy (void *object)
+	{
+		static_cast<TCallable *>(object)->~TCallable();
+	}
+
+	void finalize ()
+	{
+		for (Finalizer *finalizer = mFinalizers; finalizer; finalizer = finalizer->next) {
+			finalizer->destroy(finalizer->object);
+		}
+
+		mFinalizers = nullptr;
+	}
+
+	std::unique_ptr<uint8_t[]> mOwned;
+	uint8_t *mBuffer;
+	size_t mCapacity;
+	size_t mUsed = 0;
+	Finalizer *mFinalizers = nullptr;
+};
+
+template<typename T>
+/**
+ * @brief The ArenaAllocator class allocates from the given arena, or from the
+ * heap if there is none. Deallocation from the arena is a no-op.
+ */
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator(Arena *arena = nullptr) : mArena(arena)
+	{
+	}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) : mArena(other.arena())
+	{
+	}
+
+	T *allocate (size_t n)
+	{
+		if (mArena) {
+			return static_cast<T *>(mArena->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate (T *p, size_t n)
+	{
+		if (!mArena) {
+			std::allocator<T>().deallocate(p, n);
+		}
+	}
+
+	inline Arena *arena () const
+	{
+		return mArena;
+	}
+
+private:
+	Arena *mArena;
+};
+
+template<typename T, typename U>
+inline bool operator== (const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+{
+	return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+inline bool operator!= (const ArenaAllocator<T> &a, const ArenaAllocator<U> &b)
+{
+	return a.arena() != b.arena();
+}
+
+} /* namespace maligui */
@@ -4,6 +4,7 @@
 
 #include "Alignment.hpp"
 #include "Painter.hpp"
+#include "Style.hpp"
 #include "Widget.hpp"
 #include "FontDatabase.hpp"
 
@@ -15,33 +16,55 @@ template<typename TPixel, typename TSize = int>
  * @brief The Button class widget implements the traditional push button widget.
  * It consists of a label and is rendered as a rectangle of the given
  * dimensions. It uses Widget parent class onClick handler to call the click
- * handler in an asynchronous way.
+ * handler in an asynchronous way. Property setters do not paint the button,
+ * they only invalidate it.
+ *
+ * The look of the button is given by a shared Style (by default, the button
+ * style of the current Theme). Properties set on the button itself override
+ * the style for this button only.
  */
 class Button : public Widget<TPixel>
 {
 public:
 	/**
 	 * @brief Constructs a new button object with an empty label.
+	 * @param arena Arena the button allocates its data from, if any.
 	 */
-	Button<TPixel, TSize>() : Widget<TPixel, TSize>(), mText("") {
+	explicit Button<TPixel, TSize>(Arena *arena = nullptr) :
+		Widget<TPixel, TSize>(arena), mText("") {
+		// Background fills the whole geometry.
+		this->opaque(true);
 	}
 
 	/**
 	 * @brief Renders the button.
 	 */
-	virtual void onPaint () override
+	virtual void onPaint (Painter<TPixel> &painter) override
 	{
-		if (this->mPainter) {
-			this->mPainter->fill(mBackgroundColor);
-			this->mPainter->color(mForegroundColor);
-			this->mPainter->rect(this->mGeometry);
-			this->mPainter->setFont(mFont);
-			this->mPainter->write(mText.c_str(),
-			                      mHorizontalAlign,
-			                      mVerticalAlign);
-		}
+		painter.fill(mStyle.background());
+		painter.color(mStyle.foreground());
+		painter.rect(this->mGeometry);
+		painter.setFont(mStyle.font());
+		painter.write(mText.c_str(),
+		              mStyle.horizontalAlign(),
+		              mStyle.verticalAlign());
+
+		Widget<TPixel>::onPaint(painter);
+	}
+
+	/**
+	 * @brief Sets the shared style, nullptr for the button style of the
+	 * current theme. The style must outlive the button.
+	 */
+	void style (const Style<TPixel> *style)
+	{
+		mStyle.shared(style);
+		this->update();
+	}
 
-		Widget<TPixel>::onPaint();
+	const Style<TPixel> &style () const
+	{
+		return mStyle.shared();
 	}
 
 	/**
@@ -50,39 +73,42 @@ public:
 	 */
 	virtual TPixel backgroundColor ()
 	{
-		return this->mBackgroundColor;
+		return mStyle.background();
 	}
 
 	virtual void backgroundColor (const TPixel color)
 	{
-		this->mBackgroundColor = color;
+		mStyle.background(color, this->arena());
+		this->update();
 	}
 
 	virtual TPixel foregroundColor ()
 	{
-		return this->mForegroundColor;
+		return mStyle.foreground();
 	}
 
 	virtual void foregroundColor (const TPixel color)
 	{
-		this->mForegroundColor = color;
+		mStyle.foreground(color, this->arena());
+		this->update();
 	}
 
 	virtual TPixel borderColor ()
 	{
-		return this->mBorderColor;
+		return mStyle.border();
 	}
 
 	virtual void borderColor (const TPixel color)
 	{
-		this->mBorderColor = color;
+		mStyle.border(color, this->arena());
+		this->update();
 	}
 
 	virtual void text (const std::string &text)
 	{
 		this->mText = text;
 
-		onPaint();
+		this->update();
 	}
 
 	const std::string &text ()
@@ -90,29 +116,52 @@ public:
 		return this->mText;
 	}
 
+	using Widget<TPixel>::onClickHandler;
+
+	/**
+	 * @brief Sets the click handler, which receives the button itself rather
+	 * than a Widget, e.g. [](Button<TPixel> *button, Point<int> p) { ... }.
+	 */
+	template<typename TCallable>
+	void onClickHandler (TCallable handler)
+	{
+		this->mClickHandler =
+			Widget<TPixel>::EventHandler::template downcast<Button>(handler);
+	}
+
 	void setFont (const std::string &name, int size)
 	{
-		mFont = FontDatabase::get(name, size);
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
+	}
+
+	void setFont (const char *name, int size)
+	{
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
+	}
+
+	void setFont (FontHandle handle)
+	{
+		mStyle.font(FontDatabase::get(handle), this->arena());
+		this->update();
 	}
 
 	void horizontalAlign (align::Horizontal align)
 	{
-		this->mHorizontalAlign = align;
+		mStyle.horizontalAlign(align, this->arena());
+		this->update();
 	}
 
 	void verticalAlign (align::Vertical align)
 	{
-		this->mVerticalAlign = align;
+		mStyle.verticalAlign(align, this->arena());
+		this->update();
 	}
 
 private:
-	TPixel mBackgroundColor;
-	TPixel mForegroundColor;
-	TPixel mBorderColor;
 	std::string mText;
-	const Font *mFont = nullptr;
-	align::Horizontal mHorizontalAlign = align::Horizontal::CENTER;
-	align::Vertical mVerticalAlign     = align::Vertical::CENTER;
+	Styled<TPixel, &Theme<TPixel>::button> mStyle;
 };
 
 } /* namespace maligui */
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace maligui
+{
+
+template<typename TSignature>
+class Delegate;
+
+template<typename TResult, typename ... TArgs>
+/**
+ * @brief The Delegate class is a callable wrapper, used in place of the
+ * std::function for the event handlers. The callable is always stored inside
+ * of the delegate, so creating, copying and calling a delegate never allocates.
+ * Callables larger than CAPACITY (e.g. lambdas capturing more than a few
+ * pointers), or not trivially copyable (e.g. capturing an std::string), are
+ * rejected at compile time. Larger handlers can be stored in an Arena, and
+ * bound through the pointer (see Arena::bind()).
+ */
+class Delegate<TResult(TArgs ...)>
+{
+public:
+	/**
+	 * @brief Size of the largest callable, in bytes. Fits a function pointer
+	 * with two pointer arguments, or a pointer to a member function and the
+	 * object.
+	 */
+	static constexpr size_t CAPACITY = 3 * sizeof(void *);
+
+	constexpr Delegate() : mStorage(), mInvoke(nullptr)
+	{
+	}
+
+	constexpr Delegate(std::nullptr_t) : mStorage(), mInvoke(nullptr)
+	{
+	}
+
+	template<typename TCallable,
+	         typename = typename std::enable_if<
+	                 !std::is_same<typename std::decay<TCallable>::type, Delegate>::value>::type>
+	Delegate(TCallable callable) : mStorage()
+	{
+		store(callable);
+		mInvoke = &invoke<TCallable>;
+	}
+
+	/**
+	 * @brief Creates a delegate calling a member function of the object.
+	 */
+	template<typename TObject, TResult (TObject::*TMethod)(TArgs ...)>
+	static Delegate member (TObject *object)
+	{
+		return Delegate([object](TArgs ... args) {
+			return (object->*TMethod)(std::forward<TArgs>(args) ...);
+		});
+	}
+
+	/**
+	 * @brief Creates a delegate from the callable taking a pointer to a more
+	 * derived type as the first argument than the delegate is called with.
+	 * The argument is converted with a static_cast, so the caller must
+	 * guarantee it points to the derived type. Used by widgets to pass
+	 * themselves to the handlers as their concrete type, without RTTI.
+	 */
+	template<typename TDerived, typename TCallable>
+	static Delegate downcast (TCallable callable)
+	{
+		Delegate delegate;
+
+		delegate.store(callable);
+		delegate.mInvoke = &invokeDerived<TCallable, TDerived, TArgs ...>;
+
+		return delegate;
+	}
+
+	inline explicit operator bool () const
+	{
+		return mInvoke != nullptr;
+	}
+
+	inline TResult operator() (TArgs ... args) const
+	{
+		return mInvoke(mStorage, std::forward<TArgs>(args) ...);
+	}
+
+private:
+	typedef TResult (*Invoke)(const void *, TArgs ...);
+
+	template<typename TCallable>
+	void store (const TCallable &callable)
+	{
+		static_assert(sizeof(TCallable) <= CAPACITY,
+		              "Callable is too large for the Delegate, bind it via an Arena");
+		static_assert(alignof(TCallable) <= alignof(void *),
+		              "Callable alignment is too large for the Delegate");
+		static_assert(std::is_trivially_copyable<TCallable>::value,
+		              "Delegate only holds trivially copyable callables");
+
+		new (mStorage) TCallable(callable);
+	}
+
+	template<typename TCallable>
+	static TResult invoke (const void *storage, TArgs ... args)
+	{
+		auto &callable = *static_cast<TCallable *>(const_cast<void *>(storage));
+
+		return callable(std::forward<TArgs>(args) ...);
+	}
+
+	template<typename TCallable, typename TDerived, typename TFirst, typename ... TRest>
+	static TResult invokeDerived (const void *storage, TFirst first, TRest ... rest)
+	{
+		auto &callable = *static_cast<TCallable *>(const_cast<void *>(storage));
+
+		return callable(static_cast<TDerived *>(first), std::forward<TRest>(rest) ...);
+	}
+
+	alignas(void *) unsigned char mStorage[CAPACITY];
+	Invoke mInvoke;
+};
+
+} /* namespace maligui */
@@ -1,25 +1,48 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "Delegate.hpp"
+#include "EventQueue.hpp"
+#include "InputEvent.hpp"
 #include "Point.hpp"
+#include "Rectangle.hpp"
+
+#ifndef MALIGUI_EVENT_QUEUE_SIZE
+/**
+ * @brief Number of input events each device buffers between the two frames.
+ * Must be a power of two.
+ */
+#define MALIGUI_EVENT_QUEUE_SIZE 64
+#endif
 
 namespace maligui
 {
 
+template<typename TPixel, typename TSize>
+class Overlay;
+
 template<typename TPixel, typename TSize = int>
 /**
  * @brief The Device class wraps input/output functionalities of a hardware
  * device and serves as a Hardware Abstraction Layer. It handles output via call
  * to the setXY() method, while eventHandler can be registered to receive the
- * input in an asynchronous manner. The only supported input at this moment is
- * the "spatial" input (click/press/touch type of an event).
+ * input in an asynchronous manner. Supported input are touches (press, move
+ * and release) and key presses.
+ *
+ * Input events are not handled as they arrive. They are timestamped and queued
+ * in a lock-free queue, and passed to the event handler in a batch, once per
+ * frame, when the UI loop calls dispatchEvents(). The context delivering the
+ * input (e.g. a touch interrupt) therefore never runs the widget code.
  *
  * This is an abstract base class. The actuall device implementation only needs
  * to:
  * 1) Implement pure virtual methods such as setXY() and get().
- * 2) Call onPress() method whenever a press to the screen area is registered.
+ * 2) Call onPress(), onMove() and onRelease() methods as the screen area is
+ *    touched, and onKey() when a key is pressed. The queuePress() etc.
+ *    variants report whether the event was queued.
  *
  * @see DeviceEmulator class for an example of implementation.
  */
@@ -28,9 +51,9 @@ class Device
 protected:
 	/**
 	 * @brief EventHandler functor signature. It must be a callable object that
-	 * takes a parameter of type Point<TSize> and has no return value.
+	 * takes a parameter of type InputEvent<TSize> and has no return value.
 	 */
-	typedef std::function<void (Point<TSize> )> EventHandler;
+	typedef Delegate<void (const InputEvent<TSize> &)> EventHandler;
 
 	/**
 	 * @brief mWidth Width of the device display, in pixels.
@@ -52,6 +75,17 @@ protected:
 	 */
 	EventHandler mHandler;
 
+	/**
+	 * @brief mEvents Input events waiting to be dispatched.
+	 */
+	EventQueue<InputEvent<TSize>, MALIGUI_EVENT_QUEUE_SIZE> mEvents;
+
+	/**
+	 * @brief mTouching Whether the press of the current touch was queued.
+	 * Owned by the context reporting the input.
+	 */
+	bool mTouching = false;
+
 public:
 	Device(TSize width,
 	       TSize height) :
@@ -84,16 +118,248 @@ public:
 
 	inline virtual TPixel get (TSize offset) const = 0;
 
+	/**
+	 * @brief Reads the horizontal run of pixels. Devices with a readable frame
+	 * buffer should override it with a memory copy.
+	 */
+	inline virtual void readRow (TSize x, TSize y, TSize length, TPixel *pixels)
+	{
+		for (TSize i = 0; i < length; ++i) {
+			pixels[i] = getXY(x + i, y);
+		}
+	}
+
+	/**
+	 * @brief Writes the horizontal run of pixels. Devices should override it
+	 * with a memory copy, or a single burst transfer to the display.
+	 */
+	inline virtual void writeRow (TSize x, TSize y, TSize length, const TPixel *pixels)
+	{
+		for (TSize i = 0; i < length; ++i) {
+			setXY(x + i, y, pixels[i]);
+		}
+	}
+
+	/**
+	 * @brief Copies the pixels of the source rectangle so that its top left
+	 * corner lands at the target point, e.g. to scroll the content of an
+	 * area. Source and target may overlap. Pixels of the source not covered
+	 * by the target are left undefined, to be painted over. Both rectangles
+	 * must lie within the device.
+	 *
+	 * Rows spanning the whole width are first offered to scrollRows(). The
+	 * rest are copied in chunks, through readRow() and writeRow(), so
+	 * devices with a frame buffer should override this with a memory move.
+	 */
+	inline virtual void copyRect (const Rectangle<TSize> &source, const Point<TSize> &target)
+	{
+		TSize dx = target.x - source.x;
+		TSize dy = target.y - source.y;
+
+		if ((dx == 0 && dy == 0) || source.isEmpty()) {
+			return;
+		}
+
+		if (dx == 0 && source.x == 0 && source.width == mWidth) {
+			TSize top = dy > 0 ? source.y : target.y;
+
+			if (scrollRows(top, source.height + (dy > 0 ? dy : -dy), dy)) {
+				return;
+			}
+		}
+
+		TPixel chunk[COPY_CHUNK];
+
+		// Rows, and the chunks within them, are copied starting from the
+		// side the pixels move to, so none is overwritten before it is read.
+		for (TSize j = 0; j < source.height; ++j) {
+			TSize row = dy > 0 ? source.height - 1 - j : j;
+
+			for (TSize i = 0; i < source.width; i += COPY_CHUNK) {
+				TSize length = source.width - i < COPY_CHUNK ? source.width - i : TSize(COPY_CHUNK);
+				TSize column = dx > 0 ? source.width - i - length : i;
+
+				readRow(source.x + column, source.y + row, length, chunk);
+				writeRow(target.x + column, target.y + row, length, chunk);
+			}
+		}
+	}
+
+	/**
+	 * @brief Tells whether the frames are painted to a back buffer, and only
+	 * shown once flushed. The overlay sprites are then composited over the
+	 * frame by flush(), rather than painted to the back buffer.
+	 */
+	inline virtual bool doubleBuffered () const
+	{
+		return false;
+	}
+
+	/**
+	 * @brief Called once a frame was painted, with the area it changed.
+	 * Double buffered devices show the area here, e.g. by copying it to the
+	 * display, with the overlay composited over each row (see
+	 * Overlay::compose()). On the other devices, the overlay is already
+	 * painted.
+	 */
+	inline virtual void flush (const Rectangle<TSize> &area, const Overlay<TPixel, TSize> &overlay)
+	{
+		(void) area;
+		(void) overlay;
+	}
+
 	inline void registerEventHandler (EventHandler handler)
 	{
 		mHandler = handler;
 	}
 
+	/**
+	 * @brief Queues the press. Safe to call from an interrupt handler or an
+	 * input thread, while the UI loop runs dispatchEvents(). The press is
+	 * followed by onMove() calls while the touch moves, and an onRelease()
+	 * call once it ends. See queuePress() to know whether it was queued.
+	 */
 	inline virtual void onPress (Point<TSize> point)
 	{
-		if (mHandler) {
-			mHandler(point);
+		queuePress(point);
+	}
+
+	inline void onMove (Point<TSize> point)
+	{
+		queueMove(point);
+	}
+
+	inline void onRelease (Point<TSize> point)
+	{
+		queueRelease(point);
+	}
+
+	/**
+	 * @brief Queues the key press.
+	 * @param key Device specific key code.
+	 */
+	inline void onKey (int key)
+	{
+		queueKey(key);
+	}
+
+	/**
+	 * @brief Queues the press and the release at the same point, e.g. for
+	 * the devices that do not report the touch releases.
+	 */
+	inline void onClick (Point<TSize> point)
+	{
+		queueClick(point);
+	}
+
+	/**
+	 * @brief Queues the press, sampled at the given time (e.g. by the touch
+	 * controller). A slot of the queue is always kept for the release, so
+	 * a queued press is never left without its release.
+	 * @return false if the queue is full, and the press was dropped, together
+	 * with the moves and the release of the same touch.
+	 */
+	inline bool queuePress (Point<TSize> point,
+	                        typename InputEvent<TSize>::Clock::time_point time =
+	                        	InputEvent<TSize>::Clock::now())
+	{
+		mTouching = queue(InputEvent<TSize>::Type::PRESS, point, time, 1);
+
+		return mTouching;
+	}
+
+	/**
+	 * @brief Queues the touch movement. Moves filling the queue are dropped,
+	 * never the release following them.
+	 */
+	inline bool queueMove (Point<TSize> point,
+	                       typename InputEvent<TSize>::Clock::time_point time =
+	                       	InputEvent<TSize>::Clock::now())
+	{
+		return mTouching && queue(InputEvent<TSize>::Type::MOVE, point, time, 1);
+	}
+
+	inline bool queueRelease (Point<TSize> point,
+	                          typename InputEvent<TSize>::Clock::time_point time =
+	                          	InputEvent<TSize>::Clock::now())
+	{
+		bool touching = mTouching;
+
+		mTouching = false;
+
+		return touching && queue(InputEvent<TSize>::Type::RELEASE, point, time, 0);
+	}
+
+	inline bool queueKey (int key)
+	{
+		return mEvents.push(InputEvent<TSize> { InputEvent<TSize>::Type::KEY,
+		                                        Point<TSize> { 0, 0 },
+		                                        InputEvent<TSize>::Clock::now(),
+		                                        key }, 1);
+	}
+
+	inline bool queueClick (Point<TSize> point)
+	{
+		auto time = InputEvent<TSize>::Clock::now();
+
+		return queuePress(point, time) && queueRelease(point, time);
+	}
+
+	/**
+	 * @brief Passes all the queued events to the event handler, in order.
+	 * Called from the UI loop, once per frame.
+	 * @return Number of events dispatched.
+	 */
+	size_t dispatchEvents ()
+	{
+		InputEvent<TSize> event;
+		size_t count = 0;
+
+		while (mEvents.pop(event)) {
+			if (mHandler) {
+				mHandler(event);
+			}
+			++count;
 		}
+
+		return count;
+	}
+
+protected:
+	/**
+	 * @brief Number of pixels copyRect() moves at a time, through a buffer
+	 * on the stack.
+	 */
+	enum : int {
+		COPY_CHUNK = 32
+	};
+
+	/**
+	 * @brief Hook for the panels able to scroll in hardware, e.g. through a
+	 * vertical scroll start address register. Moves the band of rows
+	 * [top, top + height) by the distance (up if negative), and leaves the
+	 * rows moved in at either end undefined. The panel then maps the rows
+	 * of the band to new lines of its memory, which setXY() and the others
+	 * need to follow.
+	 * @return false if the move has to be done by copying the pixels, the
+	 * default.
+	 */
+	inline virtual bool scrollRows (TSize top, TSize height, TSize distance)
+	{
+		(void) top;
+		(void) height;
+		(void) distance;
+
+		return false;
+	}
+
+private:
+	inline bool queue (typename InputEvent<TSize>::Type              type,
+	                   Point<TSize>                                  point,
+	                   typename InputEvent<TSize>::Clock::time_point time,
+	                   size_t                                        reserve)
+	{
+		return mEvents.push(InputEvent<TSize> { type, point, time, 0 }, reserve);
 	}
 
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace maligui
+{
+
+template<typename T, size_t N>
+/**
+ * @brief The EventQueue class is a bounded, lock-free queue for a single
+ * producer and a single consumer, e.g. a touch interrupt handler (or an input
+ * thread) and the UI loop. Neither side ever blocks: the producer drops the
+ * events when the queue is full, and the consumer returns when it is empty.
+ * @tparam N Capacity of the queue, a power of two.
+ */
+class EventQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "Queue capacity must be a power of two");
+	// Interrupt handlers push the events, and must never wait for a lock.
+	static_assert(ATOMIC_INT_LOCK_FREE == 2, "Queue counters must be lock-free");
+
+public:
+	/**
+	 * @brief Adds the event to the queue. Called from the producer only.
+	 * @param reserve Number of slots to keep free for the events to come,
+	 *                e.g. 1 for a press, so its release always fits.
+	 * @return false if the queue is full, and the event was dropped.
+	 */
+	bool push (const T &event, size_t reserve = 0)
+	{
+		unsigned tail = mTail.load(std::memory_order_relaxed);
+
+		if (tail - mHead.load(std::memory_order_acquire) + reserve >= N) {
+			return false;
+		}
+
+		mEvents[tail & (N - 1)] = event;
+		mTail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * @brief Takes the oldest event from the queue. Called from the consumer
+	 * only.
+	 * @return false if the queue is empty.
+	 */
+	bool pop (T &event)
+	{
+		unsigned head = mHead.load(std::memory_order_relaxed);
+
+		if (head == mTail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		event = mEvents[head & (N - 1)];
+		mHead.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	inline bool empty () const
+	{
+		return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+	}
+
+	static constexpr size_t capacity ()
+	{
+		return N;
+	}
+
+private:
+	T mEvents[N];
+	// Head and tail are only ever incremented, and wrap around together.
+	std::atomic<unsigned> mHead { 0 };
+	std::atomic<unsigned> mTail { 0 };
+};
+
+} /* namespace maligui */
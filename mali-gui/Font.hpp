@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <memory>
 
@@ -15,7 +18,7 @@ public:
 	{
 	}
 
-	inline int width ()
+	inline int width () const
 	{
 		return mWidth;
 	}
@@ -30,11 +33,134 @@ public:
 		return mPixmap.end();
 	}
 
+	inline const uint8_t *data () const
+	{
+		return mPixmap.data();
+	}
+
+	inline size_t pixmapSize () const
+	{
+		return mPixmap.size();
+	}
+
 private:
 	int mWidth;
 	std::vector<uint8_t> mPixmap;
 };
 
+/**
+ * @brief The Glyph class is a non-owning view of a character pixmap. Pixmap
+ * is stored row by row, with one coverage (intensity) byte per pixel. Glyphs
+ * are returned by the Font objects, and stay valid as long as the font does.
+ */
+class Glyph
+{
+public:
+	Glyph(int width = 0, const uint8_t *begin = nullptr, const uint8_t *end = nullptr) :
+		mWidth(width),
+		mBegin(begin),
+		mEnd(end)
+	{
+	}
+
+	inline int width () const
+	{
+		return mWidth;
+	}
+
+	inline const uint8_t *begin () const
+	{
+		return mBegin;
+	}
+
+	inline const uint8_t *end () const
+	{
+		return mEnd;
+	}
+
+private:
+	int mWidth;
+	const uint8_t *mBegin;
+	const uint8_t *mEnd;
+};
+
+/**
+ * @brief The FontHandle class identifies a font by a hash of its name and size.
+ * Handles can be computed at compile time and allow the FontDatabase to look
+ * up fonts in constant time, without building or comparing strings:
+ *
+ *     constexpr FontHandle CONSOLAS_18("Consolas", 18);
+ *     button->setFont(CONSOLAS_18);
+ *
+ * The handle also keeps the name (not copied, so it must outlive the handle)
+ * and the size, to tell apart the fonts whose hashes collide.
+ */
+class FontHandle
+{
+public:
+	constexpr FontHandle(const char *name, int size) :
+		mValue(hash(name, size)),
+		mName(name),
+		mSize(size)
+	{
+	}
+
+	constexpr uint32_t value () const
+	{
+		return mValue;
+	}
+
+	constexpr const char *name () const
+	{
+		return mName;
+	}
+
+	constexpr int size () const
+	{
+		return mSize;
+	}
+
+	constexpr bool operator== (const FontHandle &other) const
+	{
+		return mValue == other.mValue;
+	}
+
+	constexpr bool operator!= (const FontHandle &other) const
+	{
+		return mValue != other.mValue;
+	}
+
+private:
+	/**
+	 * @brief 32-bit FNV-1a hash of the name, followed by the size.
+	 */
+	static constexpr uint32_t hash (const char *name, int size)
+	{
+		uint32_t value = 2166136261u;
+
+		for (; *name != '\0'; ++name) {
+			value = (value ^ static_cast<uint8_t>(*name)) * 16777619u;
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			value = (value ^ ((static_cast<uint32_t>(size) >> (8 * i)) & 0xFF)) * 16777619u;
+		}
+
+		return value;
+	}
+
+	uint32_t mValue;
+	const char *mName;
+	int mSize;
+};
+
+/**
+ * @brief The Font class holds pre-rendered character pixmaps of a single
+ * typeface at a single size. Characters are either stored as a contiguous
+ * range of ASCII codes [from, to], or as a sparse, sorted list of codes (as
+ * produced by the tools/subset_fonts.py build step). Characters missing from
+ * the font are rendered using the fallback character, if one is set.
+ */
 class Font
 {
 public:
@@ -53,22 +179,62 @@ public:
 	{
 	}
 
+	virtual ~Font() = default;
+
+	/**
+	 * @brief Constructs a subset font, containing only the listed characters.
+	 * @param name       Name of the font family.
+	 * @param size       Font size.
+	 * @param height     Height of each character pixmap, in pixels.
+	 * @param codes      Sorted ASCII codes of the contained characters.
+	 * @param characters Character pixmaps, in the same order as codes.
+	 * @param fallback   Code of the character used for codes not in font.
+	 */
+	Font(const std::string     &name,
+	     int                    size,
+	     int                    height,
+	     std::vector<uint8_t>   codes,
+	     std::vector<Character> characters,
+	     uint8_t                fallback = 0) :
+		mName(name),
+		mSize(size),
+		mHeight(height),
+		mFrom(0),
+		mTo(0),
+		mFallback(fallback),
+		mCodes(codes),
+		mCharacters(characters)
+	{
+	}
+
 	/**
 	 * @brief character provides access to the font characters.
 	 * @param ch ASCII code for the character.
-	 * @retval character object for the asked character, if found in font.
-	 * @retval empty character object, if not found.
+	 * @retval glyph of the asked character, if found in font.
+	 * @retval blank glyph, if space is asked and not found.
+	 * @retval glyph of the fallback character, if set and asked one not found.
+	 * @retval empty glyph, if not found.
 	 */
-	inline Character character (uint8_t ch) const
+	virtual Glyph character (uint8_t ch) const
 	{
-		if (ch >= mFrom) {
-			uint8_t ind = ch - mFrom;
-			if (ind < mCharacters.size()) {
-				return mCharacters.at(ind);
-			}
+		int ind = index(ch);
+
+		if (ind < 0 && ch == ' ') {
+			return blank();
+		}
+
+		if (ind < 0 && mFallback != 0) {
+			ind = index(mFallback);
 		}
 
-		return Character(0, {});
+		if (ind >= 0) {
+			const Character &character = mCharacters[ind];
+			return Glyph(character.width(),
+			             character.data(),
+			             character.data() + character.pixmapSize());
+		}
+
+		return Glyph();
 	}
 
 	inline int height () const
@@ -86,12 +252,73 @@ public:
 		return mSize;
 	}
 
+	inline FontHandle handle () const
+	{
+		return FontHandle(mName.c_str(), mSize);
+	}
+
+protected:
+	/**
+	 * @brief Constructs a font whose characters are provided by a subclass,
+	 * which needs to override character().
+	 */
+	Font(const std::string &name,
+	     int                size,
+	     int                height,
+	     uint8_t            fallback) :
+		mName(name),
+		mSize(size),
+		mHeight(height),
+		mFrom(0),
+		mTo(0),
+		mFallback(fallback)
+	{
+	}
+
+	inline uint8_t fallback () const
+	{
+		return mFallback;
+	}
+
+	/**
+	 * @brief Rendered fonts start at '!', so the space is synthesized as a
+	 * blank glyph, a quarter of the font height wide.
+	 */
+	inline Glyph blank () const
+	{
+		return Glyph(mHeight / 4);
+	}
+
 private:
+	/**
+	 * @brief Finds the position of the character within mCharacters.
+	 * @param ch ASCII code for the character.
+	 * @return Position of the character, or -1 if not found in font.
+	 */
+	inline int index (uint8_t ch) const
+	{
+		if (!mCodes.empty()) {
+			auto it = std::lower_bound(mCodes.begin(), mCodes.end(), ch);
+			if (it != mCodes.end() && *it == ch) {
+				return it - mCodes.begin();
+			}
+		} else if (ch >= mFrom) {
+			size_t ind = ch - mFrom;
+			if (ind < mCharacters.size()) {
+				return ind;
+			}
+		}
+
+		return -1;
+	}
+
 	std::string mName;
 	int mSize;
 	int mHeight;
 	uint8_t mFrom;
 	uint8_t mTo;
+	uint8_t mFallback = 0;
+	std::vector<uint8_t> mCodes;
 	std::vector<Character> mCharacters;
 
 };
@@ -1,32 +1,211 @@
 #pragma once
 
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "mali-gui/Font.hpp"
+#include "mali-gui/SdfFont.hpp"
+
+// Builds may replace the stock font set with a generated one (for example, the
+// subset emitted by tools/subset_fonts.py) by defining MALIGUI_FONTS_HEADER.
+#ifdef MALIGUI_FONTS_HEADER
+#include MALIGUI_FONTS_HEADER
+#else
 #include "mali-gui/fonts/autogen.h"
+#endif
 
 namespace maligui
 {
 
+/**
+ * @brief The FontDatabase class provides access to all fonts known to the
+ * application: the ones compiled in via fonts/autogen.h, and the ones added at
+ * runtime (e.g. MappedFont objects loaded from the file system). Fonts added
+ * at runtime take precedence over the compiled in fonts of the same name and
+ * size, so that fonts can be updated separately from the binary.
+ *
+ * Typefaces added as distance fields (see SdfTypeface) are rendered at any
+ * size asked by name, for which no bitmap font exists. Each such size is
+ * created once and then indexed as any other font.
+ *
+ * Fonts are indexed by their FontHandle, so the lookup takes constant time.
+ * Whenever possible, prefer looking fonts up by handles computed at compile
+ * time, as this avoids hashing (and with std::string, allocating) the name.
+ * Fonts whose handles collide are chained in the index, and told apart by
+ * their name and size. A handle matching a single font is trusted without
+ * comparing the names, except in the debug builds.
+ */
 class FontDatabase
 {
 
 public:
-	static inline const Font *get (const std::string &name = "", int size = 0)
+	/**
+	 * @brief Looks up the font by its handle.
+	 * @param handle Handle of the font, see FontHandle.
+	 * @return Font with the given handle, or the default font if not found.
+	 */
+	static inline const Font *get (FontHandle handle)
+	{
+		const auto &fonts = index();
+		auto range = fonts.equal_range(handle.value());
+
+		if (range.first != range.second && std::next(range.first) == range.second) {
+			// Trusted without comparing the names. Handles of the fonts absent
+			// from the database may still collide with it.
+			assert(matches(range.first->second, handle.name(), handle.size()));
+			return range.first->second;
+		}
+
+		const Font *font = find(handle);
+
+		return font ? font : &_FONTS_[0];
+	}
+
+	/**
+	 * @brief Looks up the font by its name and size.
+	 * @return Font with the given name and size, or the default font if not
+	 * found or size is zero.
+	 */
+	static inline const Font *get (const char *name, int size)
 	{
 		if (size == 0) {
 			return &_FONTS_[0];
 		}
 
-		for (const auto &font : _FONTS_) {
-			if (font.name() == name && font.size() == size) {
-				return &font;
+		const Font *font = find(FontHandle(name, size));
 
-				break;
+		if (font != nullptr) {
+			return font;
+		}
+
+		for (const SdfTypeface *typeface : typefaces()) {
+			if (typeface->name() == name) {
+				auto scaled = std::make_shared<SdfFont>(*typeface, size);
+				add(scaled);
+				return scaled.get();
 			}
 		}
 
 		return &_FONTS_[0];
 	}
 
+	static inline const Font *get (const std::string &name = "", int size = 0)
+	{
+		return get(name.c_str(), size);
+	}
+
+	/**
+	 * @brief Adds a runtime font to the database. Database shares the
+	 * ownership of the font, so the font stays valid even if the caller drops
+	 * its reference. Font replaces any font of the same name and size.
+	 * @param font Font to add. Null fonts (e.g. failed loads) are ignored.
+	 * @return true if the font was added.
+	 */
+	static inline bool add (std::shared_ptr<const Font> font)
+	{
+		if (!font) {
+			return false;
+		}
+
+		insert(index(), font.get(), true);
+		added().push_back(std::move(font));
+
+		return true;
+	}
+
+	/**
+	 * @brief Adds a distance field typeface to the database, so that it can
+	 * be looked up by name at any size. Typeface is not copied, and must
+	 * outlive the database (typically, it is a static object from the header
+	 * generated by tools/sdf_fonts.py).
+	 * @param typeface Typeface to add.
+	 */
+	static inline void add (const SdfTypeface &typeface)
+	{
+		typefaces().push_back(&typeface);
+	}
+
+private:
+	static inline std::vector<const SdfTypeface *> &typefaces ()
+	{
+		static std::vector<const SdfTypeface *> faces;
+
+		return faces;
+	}
+
+	static inline std::vector<std::shared_ptr<const Font>> &added ()
+	{
+		static std::vector<std::shared_ptr<const Font>> fonts;
+
+		return fonts;
+	}
+
+	/**
+	 * @brief Returns the handle index, building it from the compiled in fonts
+	 * on first use.
+	 */
+	typedef std::unordered_multimap<uint32_t, const Font *> Index;
+
+	static inline Index &index ()
+	{
+		static Index fonts = [] {
+			Index compiled;
+			for (const auto &font : _FONTS_) {
+				// First of the fonts with the same name and size wins.
+				insert(compiled, &font, false);
+			}
+			return compiled;
+		}();
+
+		return fonts;
+	}
+
+	static inline bool matches (const Font *font, const char *name, int size)
+	{
+		return font->size() == size && font->name() == name;
+	}
+
+	/**
+	 * @brief Adds the font to the chain of its handle, unless a font of the
+	 * same name and size is there already, which the font replaces if asked
+	 * to. Fonts of other names or sizes are kept, so collisions lose none.
+	 */
+	static inline void insert (Index &fonts, const Font *font, bool replace)
+	{
+		auto range = fonts.equal_range(font->handle().value());
+
+		for (auto it = range.first; it != range.second; ++it) {
+			if (matches(it->second, font->name().c_str(), font->size())) {
+				if (replace) {
+					it->second = font;
+				}
+				return;
+			}
+		}
+
+		fonts.emplace(font->handle().value(), font);
+	}
+
+	/**
+	 * @brief Looks the font up in the chain of its handle.
+	 * @return Font with the name and size of the handle, or nullptr.
+	 */
+	static inline const Font *find (FontHandle handle)
+	{
+		auto range = index().equal_range(handle.value());
+
+		for (auto it = range.first; it != range.second; ++it) {
+			if (matches(it->second, handle.name(), handle.size())) {
+				return it->second;
+			}
+		}
+
+		return nullptr;
+	}
+
 };
 
 } /* namespace maligui */
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+#include "InputEvent.hpp"
+#include "Point.hpp"
+
+namespace maligui
+{
+
+template<typename TSize = int>
+/**
+ * @brief The Gesture struct describes the input as seen by the widgets, as
+ * recognized by the GestureRecognizer from the raw input events.
+ */
+struct Gesture {
+	typedef std::chrono::steady_clock Clock;
+
+	enum class Type {
+		PRESS,      /**< Touch started. */
+		RELEASE,    /**< Touch ended. */
+		TAP,        /**< Touch ended close to where it started. */
+		LONG_PRESS, /**< Touch held in place for the long press time. */
+		DRAG,       /**< Touch moved. At most one per frame. */
+		SWIPE,      /**< Quick drag along one of the axes, on release. */
+		FLING,      /**< Drag released while still moving fast. */
+		KEY         /**< Key pressed. */
+	};
+
+	Type type;
+
+	/**
+	 * @brief Position the touch started at. Gestures are delivered to the
+	 * widget at this position, for the whole duration of the touch.
+	 */
+	Point<TSize> start;
+
+	/**
+	 * @brief Current position of the touch.
+	 */
+	Point<TSize> point;
+
+	/**
+	 * @brief Movement since the previous DRAG of the touch (or its start).
+	 */
+	Point<TSize> delta;
+
+	/**
+	 * @brief Velocity of the touch when released, in pixels per second. Set
+	 * for SWIPE and FLING.
+	 */
+	Point<TSize> velocity;
+
+	/**
+	 * @brief Time the gesture was recognized at (time of the last input
+	 * sample it is based on).
+	 */
+	Clock::time_point time;
+
+	/**
+	 * @brief Key code, for the KEY gestures.
+	 */
+	int key;
+};
+
+template<typename TSize = int>
+/**
+ * @brief The GestureRecognizer class turns the raw input events into the
+ * gestures. Move samples are not reported as they arrive: they only update the
+ * touch position, and a single DRAG (with the movement accumulated since the
+ * previous one) is reported when flush() is called, once per frame. Touch
+ * panels sampling at hundreds of Hz thus cause no more work than the display
+ * refresh rate allows.
+ *
+ * Gestures are reported through a callback, taking a const Gesture<TSize> &.
+ */
+class GestureRecognizer
+{
+public:
+	typedef typename Gesture<TSize>::Clock Clock;
+	typedef typename Gesture<TSize>::Type Type;
+
+	/**
+	 * @brief Processes a single input event.
+	 */
+	template<typename TCallback>
+	void process (const InputEvent<TSize> &event, TCallback callback)
+	{
+		switch (event.type) {
+		case InputEvent<TSize>::Type::PRESS:
+			press(event, callback);
+			break;
+		case InputEvent<TSize>::Type::MOVE:
+			move(event);
+			break;
+		case InputEvent<TSize>::Type::RELEASE:
+			release(event, callback);
+			break;
+		case InputEvent<TSize>::Type::KEY: {
+			Gesture<TSize> gesture = make(Type::KEY, event.time);
+
+			gesture.key = event.key;
+			callback(gesture);
+			break;
+		}
+		}
+	}
+
+	/**
+	 * @brief Reports the moves processed since the last call as a single
+	 * DRAG. Called once per frame, after the input events were processed.
+	 */
+	template<typename TCallback>
+	void flush (TCallback callback)
+	{
+		if (!mMovePending) {
+			return;
+		}
+
+		Gesture<TSize> gesture = make(Type::DRAG, mLastTime);
+
+		gesture.delta = Point<TSize> { mPoint.x - mDragged.x, mPoint.y - mDragged.y };
+		mDragged      = mPoint;
+		mMovePending  = false;
+
+		callback(gesture);
+	}
+
+	/**
+	 * @brief Reports the time based gestures (the long press). Called once
+	 * per frame.
+	 */
+	template<typename TCallback>
+	void update (typename Clock::time_point now, TCallback callback)
+	{
+		if (mPressed && !mDragging && !mLongPressed &&
+		    now - mPressTime >= mLongPressTime) {
+			mLongPressed = true;
+			callback(make(Type::LONG_PRESS, now));
+		}
+	}
+
+	/**
+	 * @brief Sets the distance the touch may move, and still be considered a
+	 * tap or a long press, rather than a drag.
+	 */
+	inline void slop (TSize distance)
+	{
+		mSlop = distance;
+	}
+
+	inline void longPressTime (typename Clock::duration time)
+	{
+		mLongPressTime = time;
+	}
+
+	/**
+	 * @brief Sets the longest duration, and the shortest distance along the
+	 * axis, of the drag recognized as a swipe.
+	 */
+	inline void swipe (typename Clock::duration time, TSize distance)
+	{
+		mSwipeTime     = time;
+		mSwipeDistance = distance;
+	}
+
+	/**
+	 * @brief Sets the lowest release velocity recognized as a fling, in pixels
+	 * per second.
+	 */
+	inline void flingVelocity (TSize velocity)
+	{
+		mFlingVelocity = velocity;
+	}
+
+private:
+	static constexpr int SAMPLES = 8;
+
+	struct Sample {
+		Point<TSize> point;
+		typename Clock::time_point time;
+	};
+
+	template<typename TCallback>
+	void press (const InputEvent<TSize> &event, TCallback callback)
+	{
+		flush(callback);
+
+		mPressed     = true;
+		mDragging    = false;
+		mLongPressed = false;
+		mStart       = event.point;
+		mPoint       = event.point;
+		mDragged     = event.point;
+		mPressTime   = event.time;
+		mSamples     = 0;
+
+		sample(event);
+		callback(make(Type::PRESS, event.time));
+	}
+
+	void move (const InputEvent<TSize> &event)
+	{
+		if (!mPressed) {
+			return;
+		}
+
+		mPoint = event.point;
+		sample(event);
+
+		if (!mDragging && distanceSquared(mStart, mPoint) > int64_t(mSlop) * mSlop) {
+			mDragging = true;
+		}
+
+		mMovePending = mDragging && (mPoint.x != mDragged.x || mPoint.y != mDragged.y);
+	}
+
+	template<typename TCallback>
+	void release (const InputEvent<TSize> &event, TCallback callback)
+	{
+		if (!mPressed) {
+			return;
+		}
+
+		move(event);
+		flush(callback);
+		mPressed = false;
+
+		callback(make(Type::RELEASE, event.time));
+
+		if (!mDragging) {
+			if (!mLongPressed) {
+				callback(make(Type::TAP, event.time));
+			}
+			return;
+		}
+
+		Gesture<TSize> gesture = make(Type::SWIPE, event.time);
+		TSize dx = mPoint.x - mStart.x;
+		TSize dy = mPoint.y - mStart.y;
+
+		gesture.velocity = velocity();
+
+		if (event.time - mPressTime <= mSwipeTime &&
+		    std::max(std::abs(dx), std::abs(dy)) >= mSwipeDistance) {
+			// Only the dominant axis counts, so the swipes are straight.
+			if (std::abs(dx) >= std::abs(dy)) {
+				gesture.delta = Point<TSize> { dx, 0 };
+			} else {
+				gesture.delta = Point<TSize> { 0, dy };
+			}
+			callback(gesture);
+		}
+
+		if (distanceSquared(Point<TSize> { 0, 0 }, gesture.velocity) >=
+		    int64_t(mFlingVelocity) * mFlingVelocity) {
+			gesture.type  = Type::FLING;
+			gesture.delta = Point<TSize> { dx, dy };
+			callback(gesture);
+		}
+	}
+
+	void sample (const InputEvent<TSize> &event)
+	{
+		mHistory[mSamples % SAMPLES] = Sample { event.point, event.time };
+		mLastTime = event.time;
+		++mSamples;
+	}
+
+	/**
+	 * @brief Velocity over the recent samples, in pixels per second.
+	 */
+	Point<TSize> velocity () const
+	{
+		if (mSamples < 2) {
+			return Point<TSize> { 0, 0 };
+		}
+
+		// Only the recent samples count, the touch may have stopped before.
+		const auto window    = std::chrono::milliseconds(100);
+		const Sample &last   = mHistory[(mSamples - 1) % SAMPLES];
+		const Sample *oldest = &last;
+
+		int count = mSamples < SAMPLES ? mSamples : SAMPLES;
+
+		for (int i = 2; i <= count; ++i) {
+			const Sample &s = mHistory[(mSamples - i) % SAMPLES];
+
+			if (last.time - s.time > window) {
+				break;
+			}
+			oldest = &s;
+		}
+
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+			last.time - oldest->time).count();
+
+		if (us <= 0) {
+			return Point<TSize> { 0, 0 };
+		}
+
+		return Point<TSize> {
+			       static_cast<TSize>((last.point.x - oldest->point.x) * 1000000LL / us),
+			       static_cast<TSize>((last.point.y - oldest->point.y) * 1000000LL / us)
+		};
+	}
+
+	Gesture<TSize> make (Type type, typename Clock::time_point time) const
+	{
+		return Gesture<TSize> { type, mStart, mPoint, Point<TSize> { 0, 0 },
+		                        Point<TSize> { 0, 0 }, time, 0 };
+	}
+
+	static inline int64_t distanceSquared (const Point<TSize> &a, const Point<TSize> &b)
+	{
+		int64_t dx = a.x - b.x;
+		int64_t dy = a.y - b.y;
+
+		return dx * dx + dy * dy;
+	}
+
+	bool mPressed     = false;
+	bool mDragging    = false;
+	bool mLongPressed = false;
+	bool mMovePending = false;
+	Point<TSize> mStart { 0, 0 };
+	Point<TSize> mPoint { 0, 0 };
+	Point<TSize> mDragged { 0, 0 };
+	typename Clock::time_point mPressTime;
+	typename Clock::time_point mLastTime;
+	Sample mHistory[SAMPLES];
+	int mSamples = 0;
+
+	TSize mSlop = 8;
+	typename Clock::duration mLongPressTime = std::chrono::milliseconds(500);
+	typename Clock::duration mSwipeTime     = std::chrono::milliseconds(300);
+	TSize mSwipeDistance = 40;
+	TSize mFlingVelocity = 500;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Point.hpp"
+#include "Rectangle.hpp"
+
+namespace maligui
+{
+
+template<typename TSize = int>
+/**
+ * @brief The GridIndex class is a uniform grid spatial index over a set of
+ * rectangles. The bounding box of the rectangles is split into roughly as
+ * many cells as there are rectangles, and each cell lists (in ascending
+ * order) the rectangles that cover it. Looking up the rectangles that may
+ * contain a point then only needs to inspect a single cell.
+ *
+ * Rectangles are registered in all the cells they touch, including their
+ * right and bottom edges, matching Rectangle::contains().
+ */
+class GridIndex
+{
+public:
+	typedef const uint32_t *Iterator;
+
+	/**
+	 * @brief Builds the index. Previous content is discarded.
+	 * @param rects Rectangles to index. Positions within this vector are
+	 *              reported by candidates().
+	 */
+	void build (const std::vector<Rectangle<TSize>> &rects)
+	{
+		mOffsets.clear();
+		mItems.clear();
+		mColumns = 0;
+		mRows    = 0;
+
+		if (rects.empty()) {
+			return;
+		}
+
+		TSize left   = rects[0].x;
+		TSize top    = rects[0].y;
+		TSize right  = rects[0].x + rects[0].width;
+		TSize bottom = rects[0].y + rects[0].height;
+
+		for (const auto &rect : rects) {
+			left   = std::min(left, rect.x);
+			top    = std::min(top, rect.y);
+			right  = std::max(right, rect.x + rect.width);
+			bottom = std::max(bottom, rect.y + rect.height);
+		}
+
+		// Edges are inclusive, so the bounds span one more pixel.
+		mBounds = Rectangle<TSize> { left, top, right - left + 1, bottom - top + 1 };
+
+		int cells = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(rects.size()))));
+		mColumns  = std::max(1, std::min(cells, static_cast<int>(mBounds.width)));
+		mRows     = std::max(1, std::min(cells, static_cast<int>(mBounds.height)));
+
+		// Counting pass, then fill, so the cells are stored back to back.
+		mOffsets.assign(mColumns * mRows + 1, 0);
+
+		forEachCell(rects, [this](size_t, int cell) {
+			++mOffsets[cell + 1];
+		});
+
+		for (size_t i = 1; i < mOffsets.size(); ++i) {
+			mOffsets[i] += mOffsets[i - 1];
+		}
+
+		std::vector<uint32_t> fill(mOffsets.begin(), mOffsets.end() - 1);
+		mItems.resize(mOffsets.back());
+
+		forEachCell(rects, [this, &fill](size_t index, int cell) {
+			mItems[fill[cell]++] = static_cast<uint32_t>(index);
+		});
+	}
+
+	/**
+	 * @brief Returns the rectangles that may contain the point, in ascending
+	 * order of their positions. Rectangles not listed do not contain it.
+	 */
+	std::pair<Iterator, Iterator> candidates (const Point<TSize> &p) const
+	{
+		if (mItems.empty() ||
+		    p.x < mBounds.x || p.x >= mBounds.x + mBounds.width ||
+		    p.y < mBounds.y || p.y >= mBounds.y + mBounds.height) {
+			return std::make_pair(Iterator(nullptr), Iterator(nullptr));
+		}
+
+		int cell = row(p.y) * mColumns + column(p.x);
+
+		return std::make_pair(mItems.data() + mOffsets[cell],
+		                      mItems.data() + mOffsets[cell + 1]);
+	}
+
+private:
+	inline int column (TSize x) const
+	{
+		return static_cast<int>(static_cast<int64_t>(x - mBounds.x) * mColumns / mBounds.width);
+	}
+
+	inline int row (TSize y) const
+	{
+		return static_cast<int>(static_cast<int64_t>(y - mBounds.y) * mRows / mBounds.height);
+	}
+
+	template<typename TCallback>
+	void forEachCell (const std::vector<Rectangle<TSize>> &rects, TCallback callback)
+	{
+		for (size_t i = 0; i < rects.size(); ++i) {
+			const auto &rect = rects[i];
+
+			if (rect.width < 0 || rect.height < 0) {
+				continue;
+			}
+
+			int lastRow    = row(rect.y + rect.height);
+			int lastColumn = column(rect.x + rect.width);
+
+			for (int r = row(rect.y); r <= lastRow; ++r) {
+				for (int c = column(rect.x); c <= lastColumn; ++c) {
+					callback(i, r * mColumns + c);
+				}
+			}
+		}
+	}
+
+	Rectangle<TSize> mBounds { 0, 0, 0, 0 };
+	int mColumns = 0;
+	int mRows    = 0;
+	std::vector<uint32_t> mOffsets;
+	std::vector<uint32_t> mItems;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+
+#include "Point.hpp"
+
+namespace maligui
+{
+
+template<typename TSize = int>
+/**
+ * @brief The InputEvent struct describes a single input sample, as reported
+ * by the Device.
+ */
+struct InputEvent {
+	typedef std::chrono::steady_clock Clock;
+
+	enum class Type {
+		PRESS,   /**< Touch started (or mouse button pressed). */
+		MOVE,    /**< Touch moved, while pressed. */
+		RELEASE, /**< Touch ended. */
+		KEY      /**< Key (button, encoder) pressed. */
+	};
+
+	Type type;
+
+	/**
+	 * @brief Position of the touch, in device coordinates.
+	 */
+	Point<TSize> point;
+
+	/**
+	 * @brief Time the input was sampled at.
+	 */
+	Clock::time_point time;
+
+	/**
+	 * @brief Device specific key code, for the KEY events.
+	 */
+	int key;
+};
+
+} /* namespace maligui */
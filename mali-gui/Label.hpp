@@ -1,68 +1,266 @@
 #pragma once
 
+#include "Alignment.hpp"
 #include "Painter.hpp"
+#include "Style.hpp"
+#include "TextLayout.hpp"
 #include "Widget.hpp"
-
-#include <QColor>
+#include "FontDatabase.hpp"
 
 namespace maligui
 {
 
 template<typename TPixel, typename TSize = int>
-class Button : public Widget<TPixel>
+/**
+ * @brief The Label class widget displays a multi-line text. The text is word
+ * wrapped to the widget width, and broken at explicit newlines. If the number
+ * of lines is limited (or the text does not fit the widget height), the last
+ * visible line is truncated with an ellipsis.
+ *
+ * When the text changes, only the lines from the first changed one are laid
+ * out and invalidated, so status and log screens that update a single line at
+ * a time are cheap to refresh.
+ *
+ * Like the Button, the label takes its look from a shared Style (by default,
+ * the label style of the current Theme), overridden by the properties set on
+ * the label itself.
+ */
+class Label : public Widget<TPixel, TSize>
 {
 public:
-	Button<TPixel, TSize>() : mText("") {
+	explicit Label<TPixel, TSize>(Arena *arena = nullptr) :
+		Widget<TPixel, TSize>(arena), mLayout(FontDatabase::get()) {
+		// Background fills the whole geometry.
+		this->opaque(true);
 	}
 
-	virtual void onPaint (Painter<TPixel> &painter) override
+	/**
+	 * @brief Renders the label.
+	 */
+	virtual void onPaint (Painter<TPixel, TSize> &painter) override
 	{
-		painter.fill(mBackgroundColor);
-		painter.color(mForegroundColor);
+		bool fits = updateLayout();
+
+		painter.fill(mStyle.background());
+		painter.color(mStyle.border());
 		painter.rect(this->mGeometry);
-		painter.write(this->geometry().start(), mText.c_str());
+		painter.color(mStyle.foreground());
+
+		if (fits) {
+			painter.write(mLayout, mStyle.horizontalAlign(), mStyle.verticalAlign());
+		}
+
+		Widget<TPixel, TSize>::onPaint(painter);
+	}
+
+	/**
+	 * @brief Sets the shared style, nullptr for the label style of the
+	 * current theme. The style must outlive the label.
+	 */
+	void style (const Style<TPixel> *style)
+	{
+		mStyle.shared(style);
+		this->update();
+	}
+
+	const Style<TPixel> &style () const
+	{
+		return mStyle.shared();
 	}
 
 	virtual TPixel backgroundColor ()
 	{
-		return this->mBackgroundColor;
+		return mStyle.background();
 	}
 
 	virtual void backgroundColor (const TPixel color)
 	{
-		this->mBackgroundColor = color;
+		mStyle.background(color, this->arena());
+		this->update();
 	}
 
 	virtual TPixel foregroundColor ()
 	{
-		return this->mForegroundColor;
+		return mStyle.foreground();
 	}
 
 	virtual void foregroundColor (const TPixel color)
 	{
-		this->mForegroundColor = color;
+		mStyle.foreground(color, this->arena());
+		this->update();
 	}
 
 	virtual TPixel borderColor ()
 	{
-		return this->mBorderColor;
+		return mStyle.border();
 	}
 
 	virtual void borderColor (const TPixel color)
 	{
-		this->mBorderColor = color;
+		mStyle.border(color, this->arena());
+		this->update();
+	}
+
+	/**
+	 * @brief Sets the text, and schedules the lines that changed for
+	 * repainting.
+	 */
+	virtual void text (const std::string &text)
+	{
+		updateLayout();
+
+		size_t lines  = mLayout.visibleLines();
+		bool   elided = mLayout.elided();
+		size_t first  = mLayout.text(text);
+
+		// Ellipsis on the last visible line depends on the hidden lines.
+		if ((elided || mLayout.elided()) && first >= mLayout.visibleLines()) {
+			first = mLayout.visibleLines() ? mLayout.visibleLines() - 1 : 0;
+		}
+
+		// Vertically centered or bottom aligned lines all move when the number
+		// of lines changes.
+		if (mStyle.verticalAlign() != align::Vertical::TOP &&
+		    lines != mLayout.visibleLines()) {
+			first = 0;
+		}
+
+		if (first >= lines && first >= mLayout.visibleLines() && first != 0) {
+			// Nothing visible has changed.
+			return;
+		}
+
+		invalidateLines(first);
+	}
+
+	const std::string &text ()
+	{
+		return mLayout.text();
+	}
+
+	using Widget<TPixel, TSize>::onClickHandler;
+
+	/**
+	 * @brief Sets the click handler, which receives the label itself rather
+	 * than a Widget, e.g. [](Label<TPixel> *label, Point<int> p) { ... }.
+	 */
+	template<typename TCallable>
+	void onClickHandler (TCallable handler)
+	{
+		this->mClickHandler =
+			Widget<TPixel, TSize>::EventHandler::template downcast<Label>(handler);
+	}
+
+	void setFont (const std::string &name, int size)
+	{
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
+	}
+
+	void setFont (const char *name, int size)
+	{
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
 	}
 
-	virtual void text (std::string t)
+	void setFont (FontHandle handle)
 	{
-		this->mText = t;
+		mStyle.font(FontDatabase::get(handle), this->arena());
+		this->update();
+	}
+
+	/**
+	 * @brief Sets the additional space between the lines, in pixels.
+	 */
+	void lineSpacing (TSize spacing)
+	{
+		mLayout.lineSpacing(spacing);
+		this->update();
+	}
+
+	/**
+	 * @brief Limits the number of lines shown, 0 for no limit. By default,
+	 * label shows as many lines as fit its height.
+	 */
+	void maxLines (size_t count)
+	{
+		mMaxLines = count;
+		this->update();
+	}
+
+	void horizontalAlign (align::Horizontal align)
+	{
+		mStyle.horizontalAlign(align, this->arena());
+		this->update();
+	}
+
+	void verticalAlign (align::Vertical align)
+	{
+		mStyle.verticalAlign(align, this->arena());
+		this->update();
+	}
+
+	const TextLayout<TSize> &layout ()
+	{
+		return mLayout;
 	}
 
 private:
-	TPixel mBackgroundColor;
-	TPixel mForegroundColor;
-	TPixel mBorderColor;
-	std::string mText;
+	/**
+	 * @brief Fits the layout to the current widget geometry and font.
+	 * @return Whether any line fits the label height.
+	 */
+	bool updateLayout ()
+	{
+		size_t fitting = 0;
+
+		// Font may have changed with the theme.
+		mLayout.font(mStyle.font() ? mStyle.font() : FontDatabase::get());
+
+		if (mLayout.lineHeight() > 0) {
+			TSize lines = (this->mGeometry.height + mLayout.lineSpacing()) /
+			              mLayout.lineHeight();
+
+			fitting = lines > 0 ? size_t(lines) : 0;
+		}
+
+		// Layout takes 0 for no limit, so the label lower than a single line
+		// keeps one line in the layout, and paints none.
+		bool fits = fitting > 0;
+
+		fitting = fits ? fitting : 1;
+
+		mLayout.width(this->mGeometry.width);
+		mLayout.maxLines(mMaxLines && mMaxLines < fitting ? mMaxLines : fitting);
+
+		return fits;
+	}
+
+	/**
+	 * @brief Invalidates the lines starting from the given one, together with
+	 * the area below them, which may hold the lines that were removed.
+	 */
+	void invalidateLines (size_t first)
+	{
+		if (first == 0) {
+			this->update();
+			return;
+		}
+
+		Rectangle<TSize> geometry = this->mGeometry;
+		TSize top    = Painter<TPixel, TSize>::lineTop(geometry, mLayout, first,
+		                                               mStyle.verticalAlign());
+		TSize bottom = geometry.y + geometry.height;
+
+		if (top < bottom) {
+			this->invalidate(Rectangle<TSize> { geometry.x, top,
+			                                    geometry.width, bottom - top });
+		}
+	}
+
+	TextLayout<TSize> mLayout;
+	size_t mMaxLines = 0;
+	Styled<TPixel, &Theme<TPixel>::label> mStyle;
 };
 
 } /* namespace maligui */
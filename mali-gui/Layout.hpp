@@ -1,3 +1,6 @@
+#pragma once
+
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -6,6 +9,36 @@
 namespace maligui
 {
 
+template<typename TSize = int>
+/**
+ * @brief Computes the geometry of a single cell of the grid. Cells are
+ * numbered left to right, top to bottom. Being constexpr, it can be used to lay
+ * out static screens at compile time (see StaticScreen).
+ * @param area          Area divided into the grid.
+ * @param numHor        Number of columns.
+ * @param numVer        Number of rows.
+ * @param paddingHor    Horizontal padding, in pixels.
+ * @param paddingVer    Vertical padding, in pixels.
+ * @param index         Index of the cell.
+ */
+constexpr Rectangle<TSize> gridCell (const Rectangle<TSize> &area,
+                                     int                     numHor,
+                                     int                     numVer,
+                                     TSize                   paddingHor,
+                                     TSize                   paddingVer,
+                                     int                     index)
+{
+	TSize stepHor = (area.width - paddingHor * (numHor - 1)) / numHor;
+	TSize stepVer = (area.height - paddingVer * (numVer - 1)) / numVer;
+
+	return Rectangle<TSize> {
+		       area.x + (index % numHor) * (stepHor + paddingHor),
+		       area.y + (index / numHor) * (stepVer + paddingVer),
+		       stepHor,
+		       stepVer
+	};
+}
+
 template<typename TPixel, typename TSize = int>
 /**
  * @brief Arranges children widgets of the container into the grid.
@@ -32,35 +65,13 @@ void makeGrid (Widget<TPixel, TSize> *container,
 
 	Rectangle<TSize> geometry = container->geometry();
 
-	TSize stepHor = (geometry.width - paddingHor * (numHor - 1)) / numHor;
-	TSize stepVer = (geometry.height - paddingVer * (numVer - 1)) / numVer;
-	TSize curY    = geometry.y;
+	size_t cells = static_cast<size_t>(numHor) * numVer;
+	size_t count = std::min(container->childrenCount(), cells);
 
-	size_t childrenCnt = container->childrenCount();
-	size_t childIndex  = 0;
-
-	for (int i = 0; i < numVer; ++i) {
-
-		TSize curX = geometry.x;
-
-		for (int j = 0; j < numHor; ++j) {
-
-			if (childIndex == childrenCnt) {
-				goto exit;
-			}
-
-			auto widget = container->childAt(childIndex);
-			widget->geometry(Rectangle<int> { curX, curY, stepHor, stepVer });
-
-			++childIndex;
-			curX += stepHor + paddingHor;
-		}
-
-		curY += stepVer + paddingVer;
+	for (size_t i = 0; i < count; ++i) {
+		container->childAt(i)->geometry(
+			gridCell(geometry, numHor, numVer, paddingHor, paddingVer, static_cast<int>(i)));
 	}
-
-exit:
-	;
 }
 
 } /* namespace maligui */
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Delegate.hpp"
+#include "Gesture.hpp"
+#include "Label.hpp"
+#include "Painter.hpp"
+#include "Rectangle.hpp"
+#include "Widget.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize = int, typename TRow = Label<TPixel, TSize>>
+/**
+ * @brief The ListView class shows a list of rows of the same height, for any
+ * number of items. Only the rows on the screen, plus a small margin, exist as
+ * widgets, and are reused for other items as the list scrolls. Each time a
+ * row is given a new item, the binder is called to fill it in, e.g.
+ * [](Label<TPixel> *row, size_t index) { row->text(entries[index]); }.
+ *
+ * When the list scrolls, its pixels are moved on the device (see
+ * Device::copyRect()), and only the newly exposed rows and the rows which
+ * changed are painted. The pixels of the widgets overlapping the list would
+ * be moved as well, so a list under popups or other widgets has to be
+ * cached (see Widget::cached()), to move the pixels offscreen instead.
+ */
+class ListView : public Widget<TPixel, TSize>
+{
+public:
+	typedef Delegate<void (TRow *, size_t)> Binder;
+
+	ListView(Rectangle<TSize> geometry = { 0, 0, 0, 0 }) :
+		ListView(nullptr, geometry)
+	{
+	}
+
+	/**
+	 * @brief Creates the list, with its rows allocated from the arena.
+	 */
+	explicit ListView(Arena *arena, Rectangle<TSize> geometry = { 0, 0, 0, 0 }) :
+		Widget<TPixel, TSize>(arena, geometry),
+		mBound(ArenaAllocator<size_t>(arena))
+	{
+		this->opaque(true);
+	}
+
+	/**
+	 * @brief Sets the function filling the rows in, and binds the visible
+	 * rows again.
+	 */
+	void binder (Binder binder)
+	{
+		mBinder = binder;
+		reload();
+	}
+
+	/**
+	 * @brief Sets the number of items, and binds the visible rows again.
+	 */
+	void count (size_t count)
+	{
+		mCount = count;
+		mOffset = std::min(mOffset, maxOffset());
+		reload();
+	}
+
+	inline size_t count () const
+	{
+		return mCount;
+	}
+
+	void rowHeight (TSize height)
+	{
+		mRowHeight = height;
+		mOffset    = std::min(mOffset, maxOffset());
+		reload();
+	}
+
+	inline TSize rowHeight () const
+	{
+		return mRowHeight;
+	}
+
+	void backgroundColor (const TPixel &color)
+	{
+		mBackground = color;
+		update();
+	}
+
+	inline const TPixel &backgroundColor () const
+	{
+		return mBackground;
+	}
+
+	/**
+	 * @brief Binds all the visible rows again, e.g. as the items changed.
+	 */
+	void reload ()
+	{
+		std::fill(mBound.begin(), mBound.end(), NONE);
+		layout();
+		update();
+	}
+
+	/**
+	 * @brief Scrolls the list, so that the given distance (in pixels) of its
+	 * content is above the top edge.
+	 */
+	void scrollTo (TSize offset)
+	{
+		offset = std::max(TSize(0), std::min(offset, maxOffset()));
+
+		if (offset == mOffset) {
+			return;
+		}
+
+		mOffset = offset;
+		layout();
+
+		// Not update(), which would render all the rows again.
+		this->invalidate(this->mGeometry);
+	}
+
+	void scrollBy (TSize distance)
+	{
+		scrollTo(mOffset + distance);
+	}
+
+	inline TSize offset () const
+	{
+		return mOffset;
+	}
+
+	/**
+	 * @brief Scrolls the list as the touch is dragged over it.
+	 */
+	virtual bool onGesture (const Gesture<TSize> &gesture) override
+	{
+		if (gesture.type == Gesture<TSize>::Type::DRAG) {
+			scrollBy(-gesture.delta.y);
+		}
+
+		return Widget<TPixel, TSize>::onGesture(gesture);
+	}
+
+	virtual void update () override
+	{
+		mRepaint = true;
+		Widget<TPixel, TSize>::update();
+	}
+
+	virtual void onPaint (Painter<TPixel, TSize> &painter) override
+	{
+		Rectangle<TSize> geometry = this->mGeometry;
+		Rectangle<TSize> clip     = painter.clip();
+		Rectangle<TSize> exposed  = clip;
+		bool kept = this->ownPixels() || this->cached();
+
+		if (geometry != mPainted) {
+			layout();
+		} else if (!mRepaint && kept && clip.covers(geometry) && painter.device() == mSurface) {
+			exposed = scroll(painter, mOffset - mPaintedOffset);
+		}
+
+		// Pixels outside of the clip are left at the old offset, so the list
+		// is painted as a whole next time.
+		mRepaint       = !clip.covers(geometry);
+		mSurface       = painter.device();
+		mPainted       = geometry;
+		mPaintedOffset = mOffset;
+
+		// Rows span the whole width, so only the space below the last one
+		// shows the background.
+		TSize end = geometry.y + TSize(mCount) * mRowHeight - mOffset;
+
+		painter.fill(exposed.intersected(Rectangle<TSize> { geometry.x, end, geometry.width,
+		                                                    geometry.y + geometry.height - end }),
+		             mBackground);
+
+		// Rows are painted where they were exposed, or as a whole if they
+		// changed themselves.
+		for (auto &row : this->mChildren) {
+			row->paint(painter, row->dirty() ? clip : exposed);
+		}
+	}
+
+private:
+	enum : size_t {
+		NONE = size_t(-1) /**< Row not bound to any item. */
+	};
+
+	/**
+	 * @brief Number of rows bound beyond each edge of the list, so scrolling
+	 * by a few pixels does not bind any rows.
+	 */
+	static constexpr size_t MARGIN = 1;
+
+	inline TSize maxOffset () const
+	{
+		TSize height = TSize(mCount) * mRowHeight - this->mGeometry.height;
+
+		return height > 0 ? height : TSize(0);
+	}
+
+	/**
+	 * @brief Moves the pixels on the device by the distance scrolled since
+	 * they were painted.
+	 * @return Area left to paint.
+	 */
+	Rectangle<TSize> scroll (Painter<TPixel, TSize> &painter, TSize distance)
+	{
+		Rectangle<TSize> geometry = this->mGeometry;
+
+		if (distance == 0) {
+			return Rectangle<TSize> { 0, 0, 0, 0 };
+		}
+
+		if (distance >= geometry.height || -distance >= geometry.height) {
+			return geometry;
+		}
+
+		painter.scroll(geometry, 0, -distance);
+
+		if (distance > 0) {
+			return Rectangle<TSize> { geometry.x, geometry.y + geometry.height - distance,
+			                          geometry.width, distance };
+		}
+
+		return Rectangle<TSize> { geometry.x, geometry.y, geometry.width, -distance };
+	}
+
+	/**
+	 * @brief Positions the rows at the current offset, and binds the ones
+	 * given new items. Item i is always shown by the row i % rows, so the
+	 * rows scrolled out are the ones reused for the items scrolled in.
+	 */
+	void layout ()
+	{
+		Rectangle<TSize> geometry = this->mGeometry;
+		size_t rows = 0;
+
+		if (mRowHeight > 0 && geometry.height > 0) {
+			rows = std::min(mCount, size_t((geometry.height + mRowHeight - 1) / mRowHeight) +
+			                        1 + 2 * MARGIN);
+		}
+
+		if (rows != mRows) {
+			createRows(rows);
+			mRows = rows;
+			mBound.assign(this->mChildren.size(), NONE);
+		}
+
+		size_t first = mRows ? size_t(mOffset / mRowHeight) : 0;
+
+		first = std::min(first > MARGIN ? first - MARGIN : 0, mCount - mRows);
+
+		for (size_t i = mRows; i < this->mChildren.size(); ++i) {
+			this->mChildren[i]->place(Rectangle<TSize> { 0, 0, 0, 0 });
+		}
+
+		for (size_t i = first; i < first + mRows; ++i) {
+			size_t slot = i % mRows;
+			TRow *row   = static_cast<TRow *>(this->mChildren[slot].get());
+
+			// Rows are painted by the list, where their pixels did not move.
+			row->place(Rectangle<TSize> { geometry.x,
+			                              geometry.y + TSize(i) * mRowHeight - mOffset,
+			                              geometry.width, mRowHeight });
+
+			if (mBound[slot] != i) {
+				mBound[slot] = i;
+
+				if (mBinder) {
+					mBinder(row, i);
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Adds the rows missing to the pool, from the arena of the list,
+	 * if any. Rows are never removed, just hidden.
+	 */
+	void createRows (size_t rows)
+	{
+		Arena *arena = this->arena();
+
+		while (this->mChildren.size() < rows) {
+			this->addChild(arena ? arena->template make<TRow>() : std::make_unique<TRow>());
+		}
+	}
+
+	Binder mBinder;
+	size_t mCount    = 0;
+	size_t mRows     = 0;
+	TSize mRowHeight = 0;
+	TSize mOffset    = 0;
+	TPixel mBackground {};
+
+	/**
+	 * @brief Index of the item each row is bound to, or NONE.
+	 */
+	std::vector<size_t, ArenaAllocator<size_t>> mBound;
+
+	/**
+	 * @brief State of the pixels on the device: the device itself, and the
+	 * geometry and offset the list was painted with.
+	 */
+	const Device<TPixel, TSize> *mSurface = nullptr;
+	Rectangle<TSize> mPainted { 0, 0, 0, 0 };
+	TSize mPaintedOffset = 0;
+	bool mRepaint        = true;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Font.hpp"
+
+namespace maligui
+{
+
+/**
+ * @brief Header of the binary font file, as written by tools/font_pack.py. All
+ * fields are little endian. The header is followed by the glyph index (count
+ * entries of FontFileGlyph, sorted by code) and by the coverage blob, holding
+ * glyph pixmaps (width x height bytes each) back to back.
+ */
+struct FontFileHeader {
+	char     magic[4];      // "MGFT"
+	uint16_t version;       // FONT_FILE_VERSION
+	uint16_t size;          // Font size
+	uint16_t height;        // Height of every glyph pixmap, in pixels
+	uint16_t count;         // Number of glyphs in the index
+	uint8_t  fallback;      // Code of the fallback glyph, 0 if none
+	uint8_t  reserved[3];
+	char     name[32];      // Font family name, NUL terminated
+};
+
+/**
+ * @brief Glyph index entry of the binary font file.
+ */
+struct FontFileGlyph {
+	uint8_t  code;          // ASCII code of the character
+	uint8_t  reserved;
+	uint16_t width;         // Width of the pixmap, in pixels
+	uint32_t offset;        // Offset of the pixmap within the coverage blob
+};
+
+static_assert(sizeof(FontFileHeader) == 48, "Unexpected font header layout");
+static_assert(sizeof(FontFileGlyph) == 8, "Unexpected font index layout");
+
+static const uint16_t FONT_FILE_VERSION = 1;
+
+/**
+ * @brief The MappedFont class provides a font stored in a binary font file,
+ * which is memory mapped and used in place. Loading only validates the header
+ * and the file size, so it takes constant time regardless of the font size;
+ * glyph pixmaps are never copied, and the pages holding them are faulted in
+ * only once the glyphs are drawn.
+ *
+ * The file stays mapped for the lifetime of the font. To update it, write the
+ * new file aside and rename it over the old one: the fonts already loaded
+ * keep the old file, and the new one is used once loaded again.
+ *
+ * Example:
+ *
+ *     FontDatabase::add(MappedFont::load("/usr/share/maligui/Consolas-18.mgf"));
+ */
+class MappedFont : public Font
+{
+public:
+	/**
+	 * @brief Maps the given font file.
+	 * @param path Path to the binary font file.
+	 * @return Font object, or nullptr if the file could not be mapped or is
+	 * not a valid font file.
+	 */
+	static std::shared_ptr<MappedFont> load (const std::string &path)
+	{
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return nullptr;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 ||
+		    static_cast<size_t>(st.st_size) < sizeof(FontFileHeader)) {
+			close(fd);
+			return nullptr;
+		}
+
+		// Private mapping, so the font does not follow writes to the file.
+		// Truncating the file would still fault the next glyph access, so
+		// the file is to be replaced (written aside and renamed over), never
+		// rewritten in place.
+		size_t length = st.st_size;
+		void  *data   = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		// Mapping holds its own reference to the file.
+		close(fd);
+
+		if (data == MAP_FAILED) {
+			return nullptr;
+		}
+
+		const FontFileHeader *header = static_cast<const FontFileHeader *>(data);
+		size_t indexEnd = sizeof(FontFileHeader) + header->count * sizeof(FontFileGlyph);
+
+		if (std::memcmp(header->magic, "MGFT", 4) != 0 ||
+		    header->version != FONT_FILE_VERSION ||
+		    header->name[sizeof(header->name) - 1] != '\0' ||
+		    indexEnd > length) {
+			munmap(data, length);
+			return nullptr;
+		}
+
+		// Glyphs are looked up sparsely, so read-ahead would only fault in
+		// pixmaps that are never drawn.
+		madvise(data, length, MADV_RANDOM);
+
+		return std::shared_ptr<MappedFont>(new MappedFont(data, length));
+	}
+
+	virtual ~MappedFont()
+	{
+		munmap(mData, mLength);
+	}
+
+	MappedFont(const MappedFont &) = delete;
+	MappedFont &operator=(const MappedFont &) = delete;
+
+	/**
+	 * @brief character provides access to the font characters, directly from
+	 * the mapped file.
+	 * @param ch ASCII code for the character.
+	 * @retval glyph of the asked character, if found in font.
+	 * @retval blank glyph, if space is asked and not found.
+	 * @retval glyph of the fallback character, if set and asked one not found.
+	 * @retval empty glyph, if not found or the file is corrupted.
+	 */
+	virtual Glyph character (uint8_t ch) const override
+	{
+		const FontFileGlyph *entry = find(ch);
+
+		if (entry == nullptr && ch == ' ') {
+			return blank();
+		}
+
+		if (entry == nullptr && fallback() != 0) {
+			entry = find(fallback());
+		}
+
+		if (entry == nullptr) {
+			return Glyph();
+		}
+
+		size_t pixmapSize = size_t { entry->width } * height();
+
+		if (entry->offset > mBlobLength ||
+		    pixmapSize > mBlobLength - entry->offset) {
+			return Glyph();
+		}
+
+		const uint8_t *pixmap = mBlob + entry->offset;
+
+		return Glyph(entry->width, pixmap, pixmap + pixmapSize);
+	}
+
+private:
+	MappedFont(void *data, size_t length) :
+		Font(header(data)->name,
+		     header(data)->size,
+		     header(data)->height,
+		     header(data)->fallback),
+		mData(data),
+		mLength(length)
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>(data);
+		size_t indexEnd = sizeof(FontFileHeader) +
+		                  header(data)->count * sizeof(FontFileGlyph);
+
+		mIndex      = reinterpret_cast<const FontFileGlyph *>(bytes + sizeof(FontFileHeader));
+		mCount      = header(data)->count;
+		mBlob       = bytes + indexEnd;
+		mBlobLength = length - indexEnd;
+	}
+
+	static inline const FontFileHeader *header (const void *data)
+	{
+		return static_cast<const FontFileHeader *>(data);
+	}
+
+	/**
+	 * @brief Binary searches the glyph index, which is sorted by code.
+	 */
+	inline const FontFileGlyph *find (uint8_t ch) const
+	{
+		const FontFileGlyph *it = std::lower_bound(
+			mIndex, mIndex + mCount, ch,
+			[](const FontFileGlyph &glyph, uint8_t code) {
+				return glyph.code < code;
+			});
+
+		if (it != mIndex + mCount && it->code == ch) {
+			return it;
+		}
+
+		return nullptr;
+	}
+
+	void *mData;
+	size_t mLength;
+	const FontFileGlyph *mIndex;
+	size_t mCount;
+	const uint8_t *mBlob;
+	size_t mBlobLength;
+};
+
+} /* namespace maligui */
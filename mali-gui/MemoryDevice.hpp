@@ -1,15 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 #include <memory>
 #include <vector>
-#include <iostream>
 
 #include "Device.hpp"
+#include "PixelTraits.hpp"
+#include "Rectangle.hpp"
 
 namespace maligui
 {
 
 template<typename TPixel, typename TSize = int>
+/**
+ * @brief The MemoryDevice class is a device painting to a buffer in memory,
+ * e.g. a frame buffer, or an offscreen surface widgets are rendered to, and
+ * copied to the screen from. Pixels painted with an intensity are blended
+ * with the buffer through PixelTraits<TPixel>::blend().
+ */
 class MemoryDevice : public Device<TPixel, TSize>
 {
 public:
@@ -20,7 +30,35 @@ public:
 	{
 	}
 
-	inline virtual void set (TSize offset, TPixel t) override
+	/**
+	 * @brief Creates an offscreen surface for the given area of the screen.
+	 * It is painted in the screen coordinates, i.e. the pixel at the area
+	 * start is stored first.
+	 */
+	MemoryDevice(const Rectangle<TSize> &area) :
+		MemoryDevice(area.width, area.height)
+	{
+		mOrigin = Point<TSize> { area.x, area.y };
+	}
+
+	inline virtual void setXY (TSize x, TSize y, TPixel t) override
+	{
+		mBuffer[offset(x, y)] = t;
+	}
+
+	inline virtual void setXYBlended (TSize x, TSize y, TPixel color, uint8_t intensity) override
+	{
+		TPixel &pixel = mBuffer[offset(x, y)];
+
+		pixel = PixelTraits<TPixel>::blend(pixel, color, intensity);
+	}
+
+	inline virtual TPixel getXY (TSize x, TSize y) override
+	{
+		return mBuffer[offset(x, y)];
+	}
+
+	inline void set (TSize offset, TPixel t)
 	{
 		mBuffer[offset] = t;
 	}
@@ -30,8 +68,97 @@ public:
 		return mBuffer[offset];
 	}
 
+	inline virtual void readRow (TSize x, TSize y, TSize length, TPixel *pixels) override
+	{
+		const TPixel *row = &mBuffer[offset(x, y)];
+
+		std::copy(row, row + length, pixels);
+	}
+
+	inline virtual void writeRow (TSize x, TSize y, TSize length, const TPixel *pixels) override
+	{
+		std::copy(pixels, pixels + length, &mBuffer[offset(x, y)]);
+	}
+
+	/**
+	 * @brief Copies the rectangle within the buffer with memmove(), as a
+	 * single move if the rectangle spans whole rows.
+	 */
+	inline virtual void copyRect (const Rectangle<TSize> &source, const Point<TSize> &target) override
+	{
+		TSize dy = target.y - source.y;
+
+		if (source.isEmpty()) {
+			return;
+		}
+
+		if (source.width == this->mWidth) {
+			return move(offset(target.x, target.y), offset(source.x, source.y),
+			            source.width * source.height);
+		}
+
+		// Rows are moved starting from the side the pixels move to, so none
+		// is overwritten before it is read.
+		for (TSize j = 0; j < source.height; ++j) {
+			TSize row = dy > 0 ? source.height - 1 - j : j;
+
+			move(offset(target.x, target.y + row), offset(source.x, source.y + row),
+			     source.width);
+		}
+	}
+
+	/**
+	 * @brief Moves the area of the screen the surface is painted for.
+	 */
+	inline void origin (const Point<TSize> &origin)
+	{
+		mOrigin = origin;
+	}
+
+	inline const Point<TSize> &origin () const
+	{
+		return mOrigin;
+	}
+
+	/**
+	 * @brief Returns the pixels, row by row, starting at the origin.
+	 */
+	inline const TPixel *data () const
+	{
+		return mBuffer.data();
+	}
+
 private:
+	/**
+	 * @brief Moves the run of pixels within the buffer. Pixel types which
+	 * cannot be copied as bytes are moved one by one.
+	 */
+	inline void move (TSize to, TSize from, TSize length)
+	{
+		move(to, from, length, std::is_trivially_copyable<TPixel>());
+	}
+
+	inline void move (TSize to, TSize from, TSize length, std::true_type)
+	{
+		std::memmove(&mBuffer[to], &mBuffer[from], length * sizeof(TPixel));
+	}
+
+	inline void move (TSize to, TSize from, TSize length, std::false_type)
+	{
+		if (to < from) {
+			std::copy(&mBuffer[from], &mBuffer[from] + length, &mBuffer[to]);
+		} else {
+			std::copy_backward(&mBuffer[from], &mBuffer[from] + length, &mBuffer[to] + length);
+		}
+	}
+
+	inline TSize offset (TSize x, TSize y) const
+	{
+		return (y - mOrigin.y) * this->mWidth + (x - mOrigin.x);
+	}
+
 	std::vector<TPixel> mBuffer;
+	Point<TSize> mOrigin { 0, 0 };
 };
 
 } /* namespace maligui */
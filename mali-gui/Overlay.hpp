@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Device.hpp"
+#include "PixelTraits.hpp"
+#include "Point.hpp"
+#include "Rectangle.hpp"
+
+#ifndef MALIGUI_OVERLAY_SIZE
+/**
+ * @brief Number of sprites an overlay can show at once.
+ */
+#define MALIGUI_OVERLAY_SIZE 4
+#endif
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize = int>
+/**
+ * @brief The Overlay class shows a few small images, sprites, on top of the
+ * widgets, e.g. a cursor, a focus highlight or a dragged item. Sprites are not
+ * widgets: moving one does not invalidate anything, and costs only the pixels
+ * of its area.
+ *
+ * On single buffered devices, each sprite keeps the pixels it covers in a
+ * backing store. Before the widgets are painted, the sprites are lifted off
+ * the device (their backing stores written back, in reverse order), and
+ * dropped onto it again once painted. Double buffered devices never have the
+ * sprites painted to the frame: they composite them over the rows as the
+ * frame is flushed, see compose().
+ *
+ * The Stacker manages the overlay of its device, see Stacker::overlay().
+ */
+class Overlay
+{
+public:
+	/**
+	 * @brief Adds the sprite, hidden, at the top left corner. The image must
+	 * outlive the sprite.
+	 * @return Index of the sprite, or -1 if the overlay is full (including
+	 * the sprites removed, but still shown until the next frame).
+	 */
+	int add (const TPixel *image, TSize width, TSize height)
+	{
+		for (int i = 0; i < MALIGUI_OVERLAY_SIZE; ++i) {
+			Sprite &sprite = mSprites[i];
+
+			if (sprite.image == nullptr && sprite.shown.isEmpty()) {
+				sprite = Sprite {};
+				sprite.image = image;
+				sprite.area  = Rectangle<TSize> { 0, 0, width, height };
+				sprite.backing.resize(width * height);
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	/**
+	 * @brief Adds the sprite, with the pixels of the key color transparent.
+	 * Pixels are compared with PixelTraits<TPixel>::equal().
+	 */
+	int add (const TPixel *image, TSize width, TSize height, const TPixel &key)
+	{
+		int index = add(image, width, height);
+
+		if (index >= 0) {
+			mSprites[index].key         = key;
+			mSprites[index].transparent = &PixelTraits<TPixel>::equal;
+		}
+
+		return index;
+	}
+
+	/**
+	 * @brief Removes the sprite. Its area is restored on the next frame.
+	 */
+	void remove (int index)
+	{
+		show(index, false);
+		mSprites[index].image = nullptr;
+	}
+
+	/**
+	 * @brief Moves the top left corner of the sprite to the point.
+	 */
+	void move (int index, const Point<TSize> &position)
+	{
+		Sprite &sprite = mSprites[index];
+
+		sprite.area.x  = position.x;
+		sprite.area.y  = position.y;
+		sprite.changed = true;
+	}
+
+	void show (int index, bool visible)
+	{
+		mSprites[index].visible = visible;
+		mSprites[index].changed = true;
+	}
+
+	inline bool visible (int index) const
+	{
+		return mSprites[index].visible;
+	}
+
+	inline const Rectangle<TSize> &area (int index) const
+	{
+		return mSprites[index].area;
+	}
+
+	/**
+	 * @brief Checks whether any sprite was moved, shown or hidden since the
+	 * sprites were last put on the screen.
+	 */
+	bool changed () const
+	{
+		for (const Sprite &sprite : mSprites) {
+			if (sprite.changed) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Checks whether any sprite on the screen intersects the area.
+	 */
+	bool intersects (const Rectangle<TSize> &area) const
+	{
+		for (const Sprite &sprite : mSprites) {
+			if (sprite.shown.intersects(area)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the areas the changed sprites
+	 * were shown at, and are to be shown at, i.e. the area a double buffered
+	 * device needs to flush again, for the sprites alone.
+	 */
+	Rectangle<TSize> damage () const
+	{
+		Rectangle<TSize> damage { 0, 0, 0, 0 };
+
+		for (const Sprite &sprite : mSprites) {
+			if (sprite.changed) {
+				damage = damage.united(sprite.shown);
+
+				if (sprite.image && sprite.visible) {
+					damage = damage.united(sprite.area);
+				}
+			}
+		}
+
+		return damage;
+	}
+
+	/**
+	 * @brief Writes the pixels under the sprites back to the device, the
+	 * last sprite first, so overlapping sprites are restored correctly.
+	 */
+	void lift (Device<TPixel, TSize> &device)
+	{
+		for (size_t i = MALIGUI_OVERLAY_SIZE; i-- > 0; ) {
+			Sprite &sprite = mSprites[i];
+			const Rectangle<TSize> &shown = sprite.shown;
+
+			for (TSize j = 0; j < shown.height; ++j) {
+				device.writeRow(shown.x, shown.y + j, shown.width, &sprite.backing[j * shown.width]);
+			}
+
+			sprite.shown = Rectangle<TSize> { 0, 0, 0, 0 };
+		}
+	}
+
+	/**
+	 * @brief Saves the pixels under the visible sprites to their backing
+	 * stores, and paints the sprites over them.
+	 */
+	void drop (Device<TPixel, TSize> &device)
+	{
+		Rectangle<TSize> bounds { 0, 0, device.width(), device.height() };
+
+		for (Sprite &sprite : mSprites) {
+			sprite.changed = false;
+
+			if (sprite.image == nullptr || !sprite.visible) {
+				continue;
+			}
+
+			Rectangle<TSize> area = sprite.area.intersected(bounds);
+
+			mLine.resize(area.width);
+
+			for (TSize j = 0; j < area.height; ++j) {
+				TPixel *backing = &sprite.backing[j * area.width];
+
+				device.readRow(area.x, area.y + j, area.width, backing);
+				std::copy(backing, backing + area.width, mLine.begin());
+				compose(sprite, area.x, area.y + j, area.width, mLine.data());
+				device.writeRow(area.x, area.y + j, area.width, mLine.data());
+			}
+
+			sprite.shown = area;
+		}
+	}
+
+	/**
+	 * @brief Paints the visible sprites over the row of pixels, e.g. as a
+	 * double buffered device copies the row of the frame to the display.
+	 * @param x      Position of the first pixel of the row.
+	 * @param y      Position of the row.
+	 * @param length Number of pixels in the row.
+	 * @param row    Pixels of the frame, to paint the sprites over.
+	 */
+	void compose (TSize x, TSize y, TSize length, TPixel *row) const
+	{
+		for (const Sprite &sprite : mSprites) {
+			if (sprite.image && sprite.visible) {
+				compose(sprite, x, y, length, row);
+			}
+		}
+	}
+
+	/**
+	 * @brief Marks the sprites as shown, once a double buffered device
+	 * flushed the frame composed with them.
+	 */
+	void composed ()
+	{
+		for (Sprite &sprite : mSprites) {
+			sprite.changed = false;
+			sprite.shown   = sprite.image && sprite.visible
+			                 ? sprite.area : Rectangle<TSize> { 0, 0, 0, 0 };
+		}
+	}
+
+private:
+	struct Sprite {
+		const TPixel *image = nullptr;
+		bool visible = false;
+		bool changed = false;
+
+		/**
+		 * @brief Key color, and the comparison of the pixels to it. Set by
+		 * the keyed add() only, so pixels need no comparison otherwise.
+		 */
+		TPixel key {};
+		bool (*transparent)(const TPixel &, const TPixel &) = nullptr;
+
+		/**
+		 * @brief Area the sprite is to be shown at.
+		 */
+		Rectangle<TSize> area { 0, 0, 0, 0 };
+
+		/**
+		 * @brief Area the sprite is shown at, and the pixels it covers there.
+		 */
+		Rectangle<TSize> shown { 0, 0, 0, 0 };
+		std::vector<TPixel> backing;
+	};
+
+	static void compose (const Sprite &sprite, TSize x, TSize y, TSize length, TPixel *row)
+	{
+		const Rectangle<TSize> &area = sprite.area;
+		TSize from = x > area.x ? x : area.x;
+		TSize to   = x + length < area.x + area.width ? x + length : area.x + area.width;
+
+		if (y < area.y || y >= area.y + area.height || from >= to) {
+			return;
+		}
+
+		const TPixel *pixels = sprite.image + (y - area.y) * area.width;
+
+		if (sprite.transparent == nullptr) {
+			std::copy(pixels + (from - area.x), pixels + (to - area.x), row + (from - x));
+			return;
+		}
+
+		for (TSize i = from; i < to; ++i) {
+			const TPixel &pixel = pixels[i - area.x];
+
+			if (!sprite.transparent(pixel, sprite.key)) {
+				row[i - x] = pixel;
+			}
+		}
+	}
+
+	Sprite mSprites[MALIGUI_OVERLAY_SIZE];
+	std::vector<TPixel> mLine;
+};
+
+} /* namespace maligui */
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <cstring>
+
 #include "Alignment.hpp"
 #include "Point.hpp"
 #include "Rectangle.hpp"
 #include "Device.hpp"
 #include "Font.hpp"
 #include "FontDatabase.hpp"
+#include "TextLayout.hpp"
 
 namespace maligui
 {
@@ -15,19 +18,88 @@ template<typename TPixel, typename TSize = int>
  * @brief The Painter class allows drawing of the basic geometric shapes to the
  * part of the screen defined by the widget's geometry. It also supports more
  * advanced features, such as text painting.
+ *
+ * A single painter is shared by all the widgets painted to the same surface.
+ * Each widget is painted with its own geometry, clip, color and font, saved
+ * before and restored after the widget is painted.
  */
 class Painter
 {
 public:
+	/**
+	 * @brief Painter properties, set for each painted widget.
+	 */
+	struct State
+	{
+		Rectangle<TSize> geometry;
+		Rectangle<TSize> clip;
+		TPixel color;
+		const Font *font;
+	};
+
+	Painter(std::shared_ptr<Device<TPixel, TSize>> surface) :
+		Painter(surface, Rectangle<TSize> { 0, 0, surface->width(), surface->height() })
+	{
+	}
+
 	Painter(std::shared_ptr<Device<TPixel, TSize>> surface,
 	        Rectangle<TSize> geometry) :
 		mDevice(surface),
 		mGeometry(geometry),
+		mClip { 0, 0, surface->width(), surface->height() },
+		mColor(),
 		mFont(nullptr)
 	{
 		mFont = FontDatabase::get();
 	}
 
+	/**
+	 * @brief Saves the painter properties, to be restored once the widget is
+	 * painted.
+	 */
+	inline State save () const
+	{
+		return State { mGeometry, mClip, mColor, mFont };
+	}
+
+	inline void restore (const State &state)
+	{
+		mGeometry = state.geometry;
+		mClip     = state.clip;
+		mColor    = state.color;
+		mFont     = state.font;
+	}
+
+	/**
+	 * @brief Sets the area aligned drawing (fill, text) is relative to,
+	 * normally the geometry of the painted widget.
+	 * @param geometry Area in device coordinates.
+	 */
+	inline void geometry (const Rectangle<TSize> &geometry)
+	{
+		mGeometry = geometry;
+	}
+
+	inline const Rectangle<TSize> &geometry () const
+	{
+		return mGeometry;
+	}
+
+	/**
+	 * @brief Restricts all the painting to the given area. Pixels outside of
+	 * it are left intact.
+	 * @param clip Area to paint to, in device coordinates.
+	 */
+	inline void clip (const Rectangle<TSize> &clip)
+	{
+		mClip = clip;
+	}
+
+	inline const Rectangle<TSize> &clip () const
+	{
+		return mClip;
+	}
+
 	inline void color (TPixel color)
 	{
 		mColor = color;
@@ -40,11 +112,15 @@ public:
 
 	inline void point (TSize x, TSize y)
 	{
-		mDevice->setXY(x, y, mColor);
+		point(x, y, mColor);
 	}
 
 	inline void point (TSize x, TSize y, TPixel color)
 	{
+		if (clipped(x, y)) {
+			return;
+		}
+
 		mDevice->setXY(x, y, color);
 	}
 
@@ -54,11 +130,7 @@ public:
 	 */
 	inline void fill (const TPixel &color)
 	{
-		for (auto i = 0; i < mGeometry.width; ++i) {
-			for (auto j = 0; j < mGeometry.height; ++j) {
-				mDevice->setXY(mGeometry.x + i, mGeometry.y + j, color);
-			}
-		}
+		fill(mGeometry, color);
 	}
 
 	inline void fill ()
@@ -66,6 +138,22 @@ public:
 		fill(mColor);
 	}
 
+	/**
+	 * @brief fill Fills the given rectangle with the provided color.
+	 * @param rect
+	 * @param color
+	 */
+	inline void fill (const Rectangle<TSize> &rect, const TPixel &color)
+	{
+		Rectangle<TSize> area = rect.intersected(mClip);
+
+		for (auto i = 0; i < area.width; ++i) {
+			for (auto j = 0; j < area.height; ++j) {
+				mDevice->setXY(area.x + i, area.y + j, color);
+			}
+		}
+	}
+
 	/**
 	 * Bresenham line drawing.
 	 * https://rosettacode.org/wiki/Bitmap/Bresenham%27s_line_algorithm
@@ -108,7 +196,50 @@ public:
 		     rect.y + rect.height - 1);
 	}
 
+	/**
+	 * @brief Copies the image to the rectangle, row by row.
+	 * @param rect   Position and size of the image, in device coordinates.
+	 * @param pixels Image pixels, rect.width per row.
+	 */
+	inline void image (const Rectangle<TSize> &rect, const TPixel *pixels)
+	{
+		Rectangle<TSize> area = rect.intersected(mClip);
+
+		for (TSize j = 0; j < area.height; ++j) {
+			const TPixel *row = pixels + (area.y + j - rect.y) * rect.width + (area.x - rect.x);
+
+			mDevice->writeRow(area.x, area.y + j, area.width, row);
+		}
+	}
+
+	/**
+	 * @brief Moves the pixels of the rectangle by the given offset, e.g. to
+	 * scroll its content, with Device::copyRect(). Pixels moved out of the
+	 * rectangle are dropped, and the ones left uncovered are undefined, to be
+	 * painted over.
+	 * @param rect Area to scroll, in device coordinates.
+	 */
+	void scroll (const Rectangle<TSize> &rect, TSize dx, TSize dy)
+	{
+		Rectangle<TSize> area   = rect.intersected(mClip);
+		Rectangle<TSize> target = Rectangle<TSize> { area.x + dx, area.y + dy,
+		                                             area.width, area.height }.intersected(area);
+
+		if (target.isEmpty()) {
+			return;
+		}
+
+		mDevice->copyRect(Rectangle<TSize> { target.x - dx, target.y - dy,
+		                                     target.width, target.height },
+		                  Point<TSize> { target.x, target.y });
+	}
+
 	inline int writeWidth (const std::string &text)
+	{
+		return writeWidth(text.c_str(), text.size());
+	}
+
+	inline int writeWidth (const char *text, size_t length)
 	{
 		int width = 0;
 
@@ -116,8 +247,8 @@ public:
 			return 0;
 		}
 
-		for (const auto &ch : text) {
-			Character c = mFont->character(ch);
+		for (size_t i = 0; i < length; ++i) {
+			Glyph c = mFont->character(text[i]);
 			width += c.width();
 		}
 
@@ -126,18 +257,30 @@ public:
 
 	TSize getHorizontalyAlignedPosition (const std::string &text,
 	                                     align::Horizontal  horizontalAlign)
+	{
+		return getHorizontalyAlignedPosition(writeWidth(text), horizontalAlign);
+	}
+
+	TSize getHorizontalyAlignedPosition (TSize             width,
+	                                     align::Horizontal horizontalAlign,
+	                                     bool              elided = false)
 	{
 		TSize x = 0;
 
+		if (elided) {
+			// Elided line is as wide as the widget, align it as if it was.
+			width = mGeometry.width;
+		}
+
 		switch (horizontalAlign) {
 		case align::Horizontal::LEFT:
 			x = mGeometry.x;
 			break;
 		case align::Horizontal::CENTER:
-			x = mGeometry.x + (mGeometry.width - writeWidth(text)) / 2;
+			x = mGeometry.x + (mGeometry.width - width) / 2;
 			break;
 		case align::Horizontal::RIGHT:
-			x = mGeometry.x + mGeometry.width - writeWidth(text);
+			x = mGeometry.x + mGeometry.width - width;
 			break;
 		}
 
@@ -182,38 +325,152 @@ public:
 	                   align::Horizontal  horizontalAlign = align::Horizontal::CENTER,
 	                   align::Vertical    verticalAlign = align::Vertical::CENTER,
 	                   const Font        *font = nullptr)
+	{
+		write(text.c_str(), text.size(), horizontalAlign, verticalAlign, font);
+	}
+
+	/**
+	 * @brief write Renders the null terminated string, without copying it.
+	 */
+	inline void write (const char        *text,
+	                   align::Horizontal  horizontalAlign = align::Horizontal::CENTER,
+	                   align::Vertical    verticalAlign = align::Vertical::CENTER,
+	                   const Font        *font = nullptr)
+	{
+		write(text, std::strlen(text), horizontalAlign, verticalAlign, font);
+	}
+
+	inline void write (const char        *text,
+	                   size_t             length,
+	                   align::Horizontal  horizontalAlign,
+	                   align::Vertical    verticalAlign,
+	                   const Font        *font = nullptr)
 	{
 		if (font) {
 			mFont = font;
 		}
 
-		TSize destX = getHorizontalyAlignedPosition(text, horizontalAlign);
+		TSize destX = getHorizontalyAlignedPosition(writeWidth(text, length), horizontalAlign);
 		TSize destY = getVerticalyAlignedPosition(verticalAlign);
 
-		renderText(text, destX, destY);
+		renderText(text, length, destX, destY);
+	}
+
+	/**
+	 * @brief write Renders the text at the given position, without aligning
+	 * it, e.g. to render the part of a line already laid out.
+	 * @return Horizontal position following the rendered text.
+	 */
+	inline TSize write (TSize x, TSize y, const char *text, size_t length)
+	{
+		return renderText(text, length, x, y);
+	}
+
+	/**
+	 * @brief write Renders the lines of the laid out text, using the layout's
+	 * font. Each line is aligned horizontally on its own, while the visible
+	 * lines are aligned vertically as a block.
+	 * @param layout
+	 * @param horizontalAlign
+	 * @param verticalAlign
+	 * @param firstLine       Index of the first line to render. Lines before
+	 *                        it are skipped, e.g. as they did not change.
+	 */
+	inline void write (const TextLayout<TSize> &layout,
+	                   align::Horizontal        horizontalAlign = align::Horizontal::LEFT,
+	                   align::Vertical          verticalAlign = align::Vertical::TOP,
+	                   size_t                   firstLine = 0)
+	{
+		const std::string &text = layout.text();
+
+		mFont = layout.font();
+
+		for (size_t i = firstLine; i < layout.visibleLines(); ++i) {
+			TSize destY = lineTop(layout, i, verticalAlign);
+
+			if (destY >= mClip.y + mClip.height) {
+				break;
+			}
+
+			if (destY + layout.lineHeight() <= mClip.y) {
+				continue;
+			}
+
+			auto  line = layout.visibleLine(i);
+			TSize destX = getHorizontalyAlignedPosition(
+				line.width, horizontalAlign, layout.elided() && i + 1 == layout.visibleLines());
+
+			destX = renderText(text.c_str() + line.start, line.length, destX, destY);
+
+			if (layout.elided() && i + 1 == layout.visibleLines()) {
+				renderText(layout.ELLIPSIS, 3, destX, destY);
+			}
+		}
+	}
+
+	/**
+	 * @brief Returns the top of the given line of the laid out text, when
+	 * aligned with the given vertical alignment.
+	 */
+	TSize lineTop (const TextLayout<TSize> &layout,
+	               size_t                   line,
+	               align::Vertical          verticalAlign)
+	{
+		return lineTop(mGeometry, layout, line, verticalAlign);
+	}
+
+	/**
+	 * @brief Returns the top of the given line of the laid out text, when
+	 * aligned within the given area.
+	 */
+	static TSize lineTop (const Rectangle<TSize>  &geometry,
+	                      const TextLayout<TSize> &layout,
+	                      size_t                   line,
+	                      align::Vertical          verticalAlign)
+	{
+		TSize y = geometry.y;
+
+		switch (verticalAlign) {
+		case align::Vertical::TOP:
+			break;
+		case align::Vertical::CENTER:
+			y += (geometry.height - layout.height()) / 2;
+			break;
+		case align::Vertical::BOTTOM:
+			y += geometry.height - layout.height();
+			break;
+		}
+
+		return y + line * layout.lineHeight();
 	}
 
 	inline Device<TPixel, TSize> *device ()
 	{
-		return &mDevice;
+		return mDevice.get();
 	}
 
 private:
-	void renderText (const std::string &text, TSize destX, TSize destY)
+	/**
+	 * @brief Renders length characters of text, starting at destX, destY.
+	 * @return Horizontal position following the rendered text.
+	 */
+	TSize renderText (const char *text, size_t length, TSize destX, TSize destY)
 	{
 		if (mFont == nullptr) {
-			return;
+			return destX;
 		}
 
-		for (const auto &ch : text) {
-			Character character = mFont->character(ch);
+		for (size_t i = 0; i < length; ++i) {
+			Glyph     character = mFont->character(text[i]);
 			int       width     = character.width();
 			int       x         = 0;
 			int       y         = 0;
 
 			for (const auto &pixval : character) {
 
-				mDevice->setXYBlended(destX + x, destY + y, mColor, pixval);
+				if (!clipped(destX + x, destY + y)) {
+					mDevice->setXYBlended(destX + x, destY + y, mColor, pixval);
+				}
 
 				if (x < width - 1) {
 					++x;
@@ -225,10 +482,19 @@ private:
 
 			destX += width;
 		}
+
+		return destX;
+	}
+
+	inline bool clipped (TSize x, TSize y) const
+	{
+		return x < mClip.x || x >= mClip.x + mClip.width ||
+		       y < mClip.y || y >= mClip.y + mClip.height;
 	}
 
 	std::shared_ptr<Device<TPixel, TSize>> mDevice;
 	Rectangle<TSize> mGeometry;
+	Rectangle<TSize> mClip;
 	TPixel mColor;
 	const Font *mFont;
 };
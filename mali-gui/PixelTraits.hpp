@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace maligui
+{
+
+template<typename TPixel>
+/**
+ * @brief The PixelTraits struct describes the operations on the pixel type
+ * that the library needs to perform itself, e.g. when painting to the
+ * offscreen surfaces. Integer pixels are taken as packed 8 bit channels (e.g.
+ * RGB888 or ARGB8888). Pixels of other types are not mixed: the color simply
+ * replaces the background from half the intensity on, so text is drawn
+ * without anti-aliasing and fades cut at their midpoint. Specialize the struct
+ * for such pixel types to blend them properly.
+ */
+struct PixelTraits
+{
+	/**
+	 * @brief Mixes the color over the background.
+	 * @param intensity Share of the color, from 0 (background only) to 255
+	 *                  (color only).
+	 */
+	static inline TPixel blend (TPixel background, TPixel color, uint8_t intensity)
+	{
+		return blend(background, color, intensity, std::is_integral<TPixel>());
+	}
+
+	/**
+	 * @brief Mixes the row of colors over the row of background pixels, e.g.
+	 * for the fades. Pixels of four channels are blended two channels at a
+	 * time, which compilers vectorize well.
+	 */
+	static inline void blend (const TPixel *background,
+	                          const TPixel *color,
+	                          TPixel       *out,
+	                          size_t        length,
+	                          uint8_t       intensity)
+	{
+		blend(background, color, out, length, intensity,
+		      std::integral_constant<bool, std::is_integral<TPixel>::value &&
+		                                   sizeof(TPixel) == 4>());
+	}
+
+	/**
+	 * @brief Checks whether the pixels are the same color, e.g. to store the
+	 * runs of the same color. Uses the operator== of the pixel type if it
+	 * has one, or compares the bytes of trivially copyable pixels. Pixels of
+	 * other types never compare equal.
+	 */
+	static inline bool equal (const TPixel &a, const TPixel &b)
+	{
+		return equal(a, b, Comparable<TPixel>(), std::is_trivially_copyable<TPixel>());
+	}
+
+private:
+	template<typename T, typename = void>
+	struct Comparable : std::false_type
+	{
+	};
+
+	template<typename T>
+	struct Comparable<T, decltype(void(std::declval<const T &>() == std::declval<const T &>()))> :
+		std::true_type
+	{
+	};
+
+	template<typename TCopyable>
+	static inline bool equal (const TPixel &a, const TPixel &b, std::true_type, TCopyable)
+	{
+		return a == b;
+	}
+
+	static inline bool equal (const TPixel &a, const TPixel &b, std::false_type, std::true_type)
+	{
+		return std::memcmp(&a, &b, sizeof(TPixel)) == 0;
+	}
+
+	static inline bool equal (const TPixel &, const TPixel &, std::false_type, std::false_type)
+	{
+		return false;
+	}
+
+	static inline TPixel blend (TPixel background, TPixel color, uint8_t intensity, std::false_type)
+	{
+		return intensity >= 128 ? color : background;
+	}
+
+	static inline TPixel blend (TPixel background, TPixel color, uint8_t intensity, std::true_type)
+	{
+		TPixel result = 0;
+
+		for (size_t i = 0; i < sizeof(TPixel); ++i) {
+			unsigned shift = 8 * i;
+			unsigned b = (background >> shift) & 0xFF;
+			unsigned c = (color >> shift) & 0xFF;
+
+			result |= TPixel((c * intensity + b * (255 - intensity) + 127) / 255) << shift;
+		}
+
+		return result;
+	}
+
+	static inline void blend (const TPixel *background,
+	                          const TPixel *color,
+	                          TPixel       *out,
+	                          size_t        length,
+	                          uint8_t       intensity,
+	                          std::false_type)
+	{
+		for (size_t i = 0; i < length; ++i) {
+			out[i] = blend(background[i], color[i], intensity);
+		}
+	}
+
+	static inline void blend (const TPixel *background,
+	                          const TPixel *color,
+	                          TPixel       *out,
+	                          size_t        length,
+	                          uint8_t       intensity,
+	                          std::true_type)
+	{
+		// Scaled to 0-256, so the division is a shift. Both ends stay exact.
+		uint32_t a = intensity + (intensity >> 7);
+
+		for (size_t i = 0; i < length; ++i) {
+			uint32_t b  = background[i];
+			uint32_t c  = color[i];
+			uint32_t rb = ((c & 0x00FF00FF) * a + (b & 0x00FF00FF) * (256 - a)) >> 8;
+			uint32_t ag = ((c >> 8) & 0x00FF00FF) * a + ((b >> 8) & 0x00FF00FF) * (256 - a);
+
+			out[i] = TPixel((rb & 0x00FF00FF) | (ag & 0xFF00FF00));
+		}
+	}
+};
+
+template<>
+/**
+ * @brief RGB565 pixels, common for the small SPI panels.
+ */
+struct PixelTraits<uint16_t>
+{
+	static inline uint16_t blend (uint16_t background, uint16_t color, uint8_t intensity)
+	{
+		unsigned r = mix(background >> 11, color >> 11, intensity);
+		unsigned g = mix((background >> 5) & 0x3F, (color >> 5) & 0x3F, intensity);
+		unsigned b = mix(background & 0x1F, color & 0x1F, intensity);
+
+		return uint16_t((r << 11) | (g << 5) | b);
+	}
+
+	static inline void blend (const uint16_t *background,
+	                          const uint16_t *color,
+	                          uint16_t       *out,
+	                          size_t          length,
+	                          uint8_t         intensity)
+	{
+		for (size_t i = 0; i < length; ++i) {
+			out[i] = blend(background[i], color[i], intensity);
+		}
+	}
+
+	static inline bool equal (uint16_t a, uint16_t b)
+	{
+		return a == b;
+	}
+
+private:
+	static inline unsigned mix (unsigned background, unsigned color, uint8_t intensity)
+	{
+		return (color * intensity + background * (255 - intensity) + 127) / 255;
+	}
+};
+
+} /* namespace maligui */
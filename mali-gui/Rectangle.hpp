@@ -25,6 +25,120 @@ struct Rectangle {
 		return Point<TSize> { x, y };
 	}
 
+	inline bool isEmpty () const
+	{
+		return width <= 0 || height <= 0;
+	}
+
+	/**
+	 * @brief Checks whether the two rectangles share at least one pixel.
+	 */
+	inline bool intersects (const Rectangle<TSize> &other) const
+	{
+		return !isEmpty() && !other.isEmpty() &&
+		       x < other.x + other.width && other.x < x + width &&
+		       y < other.y + other.height && other.y < y + height;
+	}
+
+	/**
+	 * @brief Returns the area shared by the two rectangles, or an empty
+	 * rectangle if there is none.
+	 */
+	inline Rectangle<TSize> intersected (const Rectangle<TSize> &other) const
+	{
+		if (!intersects(other)) {
+			return Rectangle<TSize> { 0, 0, 0, 0 };
+		}
+
+		TSize left   = x > other.x ? x : other.x;
+		TSize top    = y > other.y ? y : other.y;
+		TSize right  = x + width < other.x + other.width ? x + width : other.x + other.width;
+		TSize bottom = y + height < other.y + other.height ? y + height : other.y + other.height;
+
+		return Rectangle<TSize> { left, top, right - left, bottom - top };
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the two rectangles. Empty
+	 * rectangles are ignored.
+	 */
+	inline Rectangle<TSize> united (const Rectangle<TSize> &other) const
+	{
+		if (other.isEmpty()) {
+			return *this;
+		}
+
+		if (isEmpty()) {
+			return other;
+		}
+
+		TSize left   = x < other.x ? x : other.x;
+		TSize top    = y < other.y ? y : other.y;
+		TSize right  = x + width > other.x + other.width ? x + width : other.x + other.width;
+		TSize bottom = y + height > other.y + other.height ? y + height : other.y + other.height;
+
+		return Rectangle<TSize> { left, top, right - left, bottom - top };
+	}
+
+	/**
+	 * @brief Checks whether the other rectangle lies entirely within this
+	 * one. Empty rectangles are contained in any rectangle.
+	 */
+	inline bool covers (const Rectangle<TSize> &other) const
+	{
+		return other.isEmpty() ||
+		       (!isEmpty() &&
+		        other.x >= x && other.x + other.width <= x + width &&
+		        other.y >= y && other.y + other.height <= y + height);
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the area not covered by the
+	 * other rectangle. The area only shrinks when the other rectangle spans
+	 * the whole width (or height) of this one, from one of the edges.
+	 */
+	inline Rectangle<TSize> subtracted (const Rectangle<TSize> &other) const
+	{
+		if (!intersects(other)) {
+			return *this;
+		}
+
+		if (other.covers(*this)) {
+			return Rectangle<TSize> { 0, 0, 0, 0 };
+		}
+
+		Rectangle<TSize> result = *this;
+
+		if (other.x <= x && other.x + other.width >= x + width) {
+			if (other.y <= y) {
+				result.y      = other.y + other.height;
+				result.height = y + height - result.y;
+			} else if (other.y + other.height >= y + height) {
+				result.height = other.y - y;
+			}
+		} else if (other.y <= y && other.y + other.height >= y + height) {
+			if (other.x <= x) {
+				result.x     = other.x + other.width;
+				result.width = x + width - result.x;
+			} else if (other.x + other.width >= x + width) {
+				result.width = other.x - x;
+			}
+		}
+
+		return result;
+	}
+
+	inline bool operator== (const Rectangle<TSize> &other) const
+	{
+		return x == other.x && y == other.y &&
+		       width == other.width && height == other.height;
+	}
+
+	inline bool operator!= (const Rectangle<TSize> &other) const
+	{
+		return !(*this == other);
+	}
+
 };
 
 } /* namespace maligui */
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Font.hpp"
+
+namespace maligui
+{
+
+/**
+ * @brief Signed distance field of a single character. Each atlas byte holds
+ * the distance of the sample to the glyph outline: 128 lies on the outline,
+ * larger values are inside of the glyph and smaller ones outside.
+ */
+class SdfGlyph
+{
+public:
+	SdfGlyph(uint8_t code, int width, int atlasWidth, std::vector<uint8_t> distances) :
+		mCode(code),
+		mWidth(width),
+		mAtlasWidth(atlasWidth),
+		mDistances(distances)
+	{
+	}
+
+	inline uint8_t code () const
+	{
+		return mCode;
+	}
+
+	/**
+	 * @brief Width (advance) of the character at the typeface size.
+	 */
+	inline int width () const
+	{
+		return mWidth;
+	}
+
+	inline int atlasWidth () const
+	{
+		return mAtlasWidth;
+	}
+
+	inline const uint8_t *distances () const
+	{
+		return mDistances.data();
+	}
+
+private:
+	uint8_t mCode;
+	int mWidth;
+	int mAtlasWidth;
+	std::vector<uint8_t> mDistances;
+};
+
+/**
+ * @brief The SdfTypeface class holds a low resolution distance field atlas of
+ * a typeface, from which the typeface is rendered at any size. Typefaces are
+ * generated from the rendered fonts by tools/sdf_fonts.py, and registered via
+ * FontDatabase::add(), which then provides SdfFont objects for the sizes not
+ * available as bitmap fonts.
+ */
+class SdfTypeface
+{
+public:
+	/**
+	 * @param name        Name of the font family.
+	 * @param size        Font size the glyph widths and height are given for.
+	 * @param height      Height of the characters at that size, in pixels.
+	 * @param atlasHeight Height of each glyph distance field, in samples.
+	 * @param downsample  Source pixels (at the typeface size) covered by each
+	 *                    sample, in each direction. The atlas covers the glyph
+	 *                    rounded up to whole samples.
+	 * @param spread      Distance (in samples) encoded by 127 steps of the
+	 *                    distance value.
+	 * @param glyphs      Glyph distance fields, sorted by code.
+	 */
+	SdfTypeface(const std::string    &name,
+	            int                   size,
+	            int                   height,
+	            int                   atlasHeight,
+	            int                   downsample,
+	            int                   spread,
+	            std::vector<SdfGlyph> glyphs) :
+		mName(name),
+		mSize(size),
+		mHeight(height),
+		mAtlasHeight(atlasHeight),
+		mDownsample(downsample),
+		mSpread(spread),
+		mGlyphs(glyphs)
+	{
+	}
+
+	inline const std::string &name () const
+	{
+		return mName;
+	}
+
+	inline int size () const
+	{
+		return mSize;
+	}
+
+	inline int height () const
+	{
+		return mHeight;
+	}
+
+	inline int atlasHeight () const
+	{
+		return mAtlasHeight;
+	}
+
+	inline int downsample () const
+	{
+		return mDownsample;
+	}
+
+	inline int spread () const
+	{
+		return mSpread;
+	}
+
+	inline const std::vector<SdfGlyph> &glyphs () const
+	{
+		return mGlyphs;
+	}
+
+	/**
+	 * @brief Finds the position of the glyph within glyphs().
+	 * @return Position of the glyph, or -1 if not found in typeface.
+	 */
+	int index (uint8_t ch) const
+	{
+		auto it = std::lower_bound(mGlyphs.begin(), mGlyphs.end(), ch,
+		                           [](const SdfGlyph &glyph, uint8_t code) {
+			return glyph.code() < code;
+		});
+
+		if (it != mGlyphs.end() && it->code() == ch) {
+			return it - mGlyphs.begin();
+		}
+
+		return -1;
+	}
+
+private:
+	std::string mName;
+	int mSize;
+	int mHeight;
+	int mAtlasHeight;
+	int mDownsample;
+	int mSpread;
+	std::vector<SdfGlyph> mGlyphs;
+};
+
+/**
+ * @brief The SdfFont class renders a SdfTypeface at the given size. Glyphs are
+ * rasterized from the distance field on the first use, by bilinearly sampling
+ * the atlas and mapping the distance to coverage through a smoothstep lookup
+ * table, and cached from then on. Drawing text therefore costs the same as
+ * with the bitmap fonts, once the characters were drawn for the first time.
+ */
+class SdfFont : public Font
+{
+public:
+	SdfFont(const SdfTypeface &typeface, int size) :
+		Font(typeface.name(),
+		     size,
+		     scaled(typeface.height(), size, typeface.size()),
+		     '?'),
+		mTypeface(typeface),
+		mCache(typeface.glyphs().size()),
+		mCached(typeface.glyphs().size(), false)
+	{
+		buildCoverageTable();
+	}
+
+	virtual Glyph character (uint8_t ch) const override
+	{
+		int ind = mTypeface.index(ch);
+
+		if (ind < 0 && ch == ' ') {
+			return blank();
+		}
+
+		if (ind < 0) {
+			ind = mTypeface.index(fallback());
+		}
+
+		if (ind < 0) {
+			return Glyph();
+		}
+
+		const SdfGlyph &glyph = mTypeface.glyphs()[ind];
+		int width = scaled(glyph.width(), size(), mTypeface.size());
+
+		if (!mCached[ind]) {
+			rasterize(glyph, width, mCache[ind]);
+			mCached[ind] = true;
+		}
+
+		const std::vector<uint8_t> &pixmap = mCache[ind];
+
+		return Glyph(width, pixmap.data(), pixmap.data() + pixmap.size());
+	}
+
+private:
+	static inline int scaled (int value, int size, int baseSize)
+	{
+		return (value * size + baseSize / 2) / baseSize;
+	}
+
+	/**
+	 * @brief Builds the table mapping the distance values to coverage. The
+	 * antialiasing ramp is one output pixel wide, so it gets narrower (in
+	 * distance units) as the font gets larger.
+	 */
+	void buildCoverageTable ()
+	{
+		// Distance units per output pixel.
+		float unitsPerPixel = 127.0f * mTypeface.size() /
+		                      (mTypeface.spread() * mTypeface.downsample() * std::max(size(), 1));
+		float halfRamp = std::max(unitsPerPixel / 2.0f, 1.0f);
+
+		for (int d = 0; d < 256; ++d) {
+			float t = (d - (128.0f - halfRamp)) / (2.0f * halfRamp);
+			t = std::min(std::max(t, 0.0f), 1.0f);
+			mCoverage[d] = static_cast<uint8_t>(t * t * (3.0f - 2.0f * t) * 255.0f + 0.5f);
+		}
+	}
+
+	/**
+	 * @brief Rasterizes the glyph at the font size. Atlas is sampled in 16.16
+	 * fixed point, so the inner loop stays integer only.
+	 */
+	void rasterize (const SdfGlyph &glyph, int width, std::vector<uint8_t> &pixmap) const
+	{
+		int atlasWidth  = glyph.atlasWidth();
+		int atlasHeight = mTypeface.atlasHeight();
+		int outHeight   = height();
+
+		pixmap.assign(static_cast<size_t>(width) * outHeight, 0);
+
+		if (width <= 0 || outHeight <= 0 || atlasWidth <= 0 || atlasHeight <= 0 || size() <= 0) {
+			return;
+		}
+
+		// Atlas samples per output pixel, the same in both directions. The
+		// atlas extends past the glyph to whole samples, so it is not
+		// stretched over the glyph width.
+		const uint8_t *atlas = glyph.distances();
+		int32_t step  = static_cast<int32_t>((int64_t(mTypeface.size()) << 16) /
+		                                     (mTypeface.downsample() * size()));
+		int32_t maxX  = (atlasWidth - 1) << 16;
+		int32_t maxY  = (atlasHeight - 1) << 16;
+		uint8_t *out  = pixmap.data();
+
+		for (int y = 0; y < outHeight; ++y) {
+			// Sample at the pixel centers.
+			int32_t sy = std::min(std::max(step * y + step / 2 - (1 << 15), 0), maxY);
+			int     y0 = sy >> 16;
+			int     y1 = std::min(y0 + 1, atlasHeight - 1);
+			int32_t fy = (sy >> 8) & 0xFF;
+			const uint8_t *row0 = atlas + y0 * atlasWidth;
+			const uint8_t *row1 = atlas + y1 * atlasWidth;
+
+			for (int x = 0; x < width; ++x) {
+				int32_t sx = std::min(std::max(step * x + step / 2 - (1 << 15), 0), maxX);
+				int     x0 = sx >> 16;
+				int     x1 = std::min(x0 + 1, atlasWidth - 1);
+				int32_t fx = (sx >> 8) & 0xFF;
+
+				int32_t top    = row0[x0] * (256 - fx) + row0[x1] * fx;
+				int32_t bottom = row1[x0] * (256 - fx) + row1[x1] * fx;
+				int32_t d      = (top * (256 - fy) + bottom * fy) >> 16;
+
+				*out++ = mCoverage[d];
+			}
+		}
+	}
+
+	const SdfTypeface &mTypeface;
+	uint8_t mCoverage[256];
+	mutable std::vector<std::vector<uint8_t>> mCache;
+	mutable std::vector<bool> mCached;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <vector>
+
+#include "Device.hpp"
+#include "PixelTraits.hpp"
+#include "Rectangle.hpp"
+
+namespace maligui
+{
+
+/**
+ * @brief How the pixels hidden behind a layer are kept, to be restored when
+ * the layer is removed.
+ */
+enum class SnapshotMode {
+	NONE,       /**< Not kept, the uncovered widgets are repainted. */
+	FULL,       /**< Kept as they are, restored with a row copy. */
+	COMPRESSED  /**< Kept as runs of the same color, for low memory devices. */
+};
+
+template<typename TPixel, typename TSize = int>
+/**
+ * @brief The Snapshot class keeps a copy of an area of the device, e.g. the
+ * pixels a dialog covers, so they can be put back without repainting the
+ * widgets behind it. Compressed snapshots store runs of the same color, which
+ * takes a fraction of the memory for the flat backgrounds typical for the
+ * embedded screens. Colors are compared with PixelTraits<TPixel>::equal().
+ */
+class Snapshot
+{
+public:
+	/**
+	 * @brief Copies the area of the device. The area is limited to the device
+	 * bounds.
+	 */
+	void capture (Device<TPixel, TSize> &device,
+	              Rectangle<TSize>       area,
+	              SnapshotMode           mode)
+	{
+		clear();
+
+		mArea = area.intersected(Rectangle<TSize> { 0, 0, device.width(), device.height() });
+		mMode = mode;
+
+		if (mMode == SnapshotMode::NONE || mArea.isEmpty()) {
+			mMode = SnapshotMode::NONE;
+			return;
+		}
+
+		if (mMode == SnapshotMode::FULL) {
+			mPixels.resize(mArea.width * mArea.height);
+
+			for (TSize row = 0; row < mArea.height; ++row) {
+				device.readRow(mArea.x, mArea.y + row, mArea.width,
+				               &mPixels[row * mArea.width]);
+			}
+			return;
+		}
+
+		std::vector<TPixel> line(mArea.width);
+
+		for (TSize row = 0; row < mArea.height; ++row) {
+			device.readRow(mArea.x, mArea.y + row, mArea.width, line.data());
+
+			for (const TPixel &pixel : line) {
+				// Runs continue over the row ends, backgrounds span many rows.
+				if (!mRuns.empty() && PixelTraits<TPixel>::equal(mRuns.back().pixel, pixel)) {
+					++mRuns.back().length;
+				} else {
+					mRuns.push_back(Run { pixel, 1 });
+				}
+			}
+		}
+
+		mRuns.shrink_to_fit();
+	}
+
+	/**
+	 * @brief Writes the copied pixels back to the device.
+	 */
+	void restore (Device<TPixel, TSize> &device) const
+	{
+		if (mMode == SnapshotMode::FULL) {
+			for (TSize row = 0; row < mArea.height; ++row) {
+				device.writeRow(mArea.x, mArea.y + row, mArea.width,
+				                &mPixels[row * mArea.width]);
+			}
+			return;
+		}
+
+		if (mMode != SnapshotMode::COMPRESSED) {
+			return;
+		}
+
+		std::vector<TPixel> line(mArea.width);
+		TSize row    = 0;
+		TSize column = 0;
+
+		for (const Run &run : mRuns) {
+			for (TSize i = 0; i < run.length; ++i) {
+				line[column] = run.pixel;
+
+				if (++column == mArea.width) {
+					device.writeRow(mArea.x, mArea.y + row, mArea.width, line.data());
+					column = 0;
+					++row;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Releases the copied pixels.
+	 */
+	void clear ()
+	{
+		std::vector<TPixel>().swap(mPixels);
+		std::vector<Run>().swap(mRuns);
+		mMode = SnapshotMode::NONE;
+		mArea = Rectangle<TSize> { 0, 0, 0, 0 };
+	}
+
+	inline bool valid () const
+	{
+		return mMode != SnapshotMode::NONE;
+	}
+
+	inline const Rectangle<TSize> &area () const
+	{
+		return mArea;
+	}
+
+	/**
+	 * @brief Memory taken by the copied pixels, in bytes.
+	 */
+	inline size_t memory () const
+	{
+		return mPixels.capacity() * sizeof(TPixel) + mRuns.capacity() * sizeof(Run);
+	}
+
+private:
+	struct Run {
+		TPixel pixel;
+		TSize length;
+	};
+
+	SnapshotMode mMode = SnapshotMode::NONE;
+	Rectangle<TSize> mArea { 0, 0, 0, 0 };
+	std::vector<TPixel> mPixels;
+	std::vector<Run> mRuns;
+};
+
+} /* namespace maligui */
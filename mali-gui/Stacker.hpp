@@ -1,13 +1,29 @@
-#include <stack>
-#include <functional>
+#pragma once
 
+#include <chrono>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Gesture.hpp"
 #include "MemoryDevice.hpp"
+#include "Overlay.hpp"
 #include "Widget.hpp"
 #include "Painter.hpp"
+#include "Snapshot.hpp"
+#include "Transition.hpp"
 
 namespace maligui
 {
 
+/**
+ * @brief How the touches outside of a popup are handled.
+ */
+enum class Modality {
+	MODAL,     /**< Ignored, e.g. for dialogs. */
+	MODELESS,  /**< Delivered to the layers behind, e.g. for toasts. */
+	DISMISS    /**< Close the popup, e.g. for dropdowns and menus. */
+};
+
 template<typename TPixel, typename TSize = int>
 /**
  * @brief The Stacker class provides basic functionality needed to transition
@@ -20,32 +36,299 @@ template<typename TPixel, typename TSize = int>
  * only after pop is called to remove the last added window. As the name
  * suggests, stacker is LIFO, so last added widget is the first one that will be
  * poped.
+ *
+ * Widgets are not painted as they change. Changes only invalidate the widgets,
+ * and the stacker repaints all the damage in a single pass per frame, when its
+ * tick() method is called by the platform (e.g. from a timer, a vsync
+ * interrupt, or an idle loop).
+ *
+ * Optionally, the pixels each pushed widget covers are kept in a snapshot
+ * (see snapshots()), so popping the widget copies them back instead of
+ * repainting the widgets behind it.
+ *
+ * Screens can also be switched with an animation (see transitions()), composed
+ * from the offscreen images of the screen before and after the switch.
+ *
+ * Widgets smaller than the screen (dialogs, dropdowns, toasts) can be opened as
+ * popups (see popup()). Popups always save the pixels under them, and touches
+ * outside of them are handled according to their modality.
+ *
+ * Sprites shown over all the layers (see overlay()) are lifted off the device
+ * while the frames are painted under them, or, on double buffered devices,
+ * composited over the frames as they are flushed.
  */
 class Stacker
 {
 public:
 	Stacker(std::shared_ptr<Device<TPixel>> device) :
-		mDevice(device)
+		mDevice(device),
+		mPainter(device)
 	{
-		device->registerEventHandler(std::bind(&Stacker::onClick, this,
-		                                       std::placeholders::_1));
+		device->registerEventHandler([this](const InputEvent<TSize> &event) {
+			mGestures.process(event, [this](const Gesture<TSize> &gesture) {
+				onGesture(gesture);
+			});
+		});
 	}
 
+	typedef typename Widget<TPixel, TSize>::Clock Clock;
+
+	/**
+	 * @brief Makes the widget active. Widget is painted on the next frame.
+	 */
 	void push (Widget<TPixel, TSize> *widget)
 	{
-		mStack.push(widget);
-		widget->initPainter(mDevice);
-		widget->onPaint();
+		add(Layer { widget, false, Modality::MODAL, mTransitionType, mSnapshotMode, {},
+		            nullptr, nullptr });
+	}
+
+	/**
+	 * @brief Makes the widget active, and takes the ownership of it, and of
+	 * the arena it was allocated from (if any). Both are released when the
+	 * widget is popped.
+	 */
+	void push (std::unique_ptr<Widget<TPixel, TSize>> widget,
+	           std::unique_ptr<Arena>                 arena = nullptr)
+	{
+		Widget<TPixel, TSize> *top = widget.get();
+
+		add(Layer { top, false, Modality::MODAL, mTransitionType, mSnapshotMode, {},
+		            std::move(arena), std::move(widget) });
+	}
+
+	/**
+	 * @brief Opens the widget as a popup, on top of the active widget. The
+	 * pixels under the popup are saved when it is painted for the first time
+	 * (in full, unless compressed snapshots are set), and restored when the
+	 * popup is closed with pop(), so the widgets behind are not repainted.
+	 * Touches inside of the popup are delivered to it, and the ones outside
+	 * according to the modality. Popups are opened and closed without the
+	 * transition.
+	 */
+	void popup (Widget<TPixel, TSize> *widget, Modality modality = Modality::MODAL)
+	{
+		add(Layer { widget, true, modality, TransitionType::NONE, saveUnderMode(), {},
+		            nullptr, nullptr });
+	}
+
+	/**
+	 * @brief Opens the widget as a popup, and takes the ownership of it.
+	 */
+	void popup (std::unique_ptr<Widget<TPixel, TSize>> widget,
+	            Modality                               modality = Modality::MODAL)
+	{
+		Widget<TPixel, TSize> *top = widget.get();
+
+		add(Layer { top, true, modality, TransitionType::NONE, saveUnderMode(), {},
+		            nullptr, std::move(widget) });
+	}
+
+	/**
+	 * @brief Removes the active widget, and makes the previously pushed one
+	 * active again. The area of the removed widget is restored from its
+	 * snapshot, or repainted, on the next frame. If the widget was pushed with
+	 * a transition, the transition is played in reverse.
+	 */
+	void pop ()
+	{
+		if (mLayers.empty()) {
+			return;
+		}
+
+		const Layer &top = mLayers.back();
+
+		animate(top.widget->geometry(), reversed(top.transition), [this]() {
+			remove();
+		});
 	}
 
+	/**
+	 * @brief Immediately dispatches the queued input events, and repaints the
+	 * parts of the widgets that were invalidated since the last paint,
+	 * regardless of the frame schedule.
+	 */
 	void refresh ()
 	{
-		mStack.top()->onPaint();
+		dispatchEvents();
+		frame(damage(), [this]() {
+			finishTransition();
+			paintLayers(Clock::time_point::max());
+		});
+	}
+
+	/**
+	 * @brief Runs the frame scheduler. Input events queued by the device are
+	 * dispatched first, all in one batch, with the touch moves coalesced to a
+	 * single drag. Then, if a frame is due, the next frame of the running
+	 * transition is painted, or, if the widgets have damaged areas, they are
+	 * repainted in a single pass. Widgets fully covered by an
+	 * opaque widget pushed after them are not painted. Passes that would take
+	 * longer than the frame budget are split, and continued on the following
+	 * frames. Can be called at the panel refresh rate, or more often (e.g.
+	 * whenever idle), as frames are never painted more often than the frame
+	 * interval.
+	 * @return true if a frame was painted.
+	 */
+	bool tick ()
+	{
+		dispatchEvents();
+
+		if (!pending()) {
+			return false;
+		}
+
+		auto now = Clock::now();
+
+		if (now - mLastFrame < mFrameInterval) {
+			return false;
+		}
+
+		mLastFrame = now;
+
+		frame(damage(), [this, now]() {
+			if (mTransition) {
+				// Damage waits for the transition to end.
+				if (mTransition->frame(*mDevice, now)) {
+					mTransition.reset();
+				}
+				return;
+			}
+
+			paintLayers(now + mFrameBudget);
+		});
+
+		return true;
+	}
+
+	/**
+	 * @brief Schedules all the widgets for repainting, e.g. after the theme
+	 * was switched.
+	 */
+	void update ()
+	{
+		for (auto &layer : mLayers) {
+			layer.widget->updateAll();
+		}
+	}
+
+	/**
+	 * @brief Checks whether any damage is waiting to be painted.
+	 */
+	inline bool pending () const
+	{
+		if (mTransition || !mRestores.empty() || mOverlay.changed()) {
+			return true;
+		}
+
+		for (const auto &layer : mLayers) {
+			if (layer.widget->damaged()) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Sets how the pixels covered by the widgets pushed from now on are
+	 * kept. By default, they are not kept, and the widgets behind are
+	 * repainted when the covering widget is popped. Snapshots are taken when
+	 * the widget is painted for the first time, and are dropped (falling back
+	 * to the repaint) if the widgets behind change in the meantime.
+	 */
+	inline void snapshots (SnapshotMode mode)
+	{
+		mSnapshotMode = mode;
+	}
+
+	/**
+	 * @brief Sets the animation played when the widgets pushed from now on
+	 * are pushed, and, in reverse, popped. Each frame shows the state the
+	 * animation should be in at the time, so it lasts the given time even if
+	 * some frames are dropped.
+	 */
+	inline void transitions (TransitionType type, typename Clock::duration duration)
+	{
+		mTransitionType = type;
+		mTransitionTime = duration;
+	}
+
+	/**
+	 * @brief Sets the minimal time between the two painted frames.
+	 */
+	inline void frameInterval (typename Clock::duration interval)
+	{
+		mFrameInterval = interval;
+	}
+
+	/**
+	 * @brief Sets the maximal time a single frame may spend painting.
+	 */
+	inline void frameBudget (typename Clock::duration budget)
+	{
+		mFrameBudget = budget;
+	}
+
+	/**
+	 * @brief Delivers the gesture to the active widget. Taps are delivered
+	 * as clicks as well. Keys are delivered to the active widget itself, as
+	 * they have no position.
+	 */
+	void onGesture (const Gesture<TSize> &gesture)
+	{
+		if (mLayers.empty()) {
+			return;
+		}
+
+		if (gesture.type == Gesture<TSize>::Type::KEY) {
+			mLayers.back().widget->onGesture(gesture);
+			return;
+		}
+
+		// The whole touch goes to the widget it started on.
+		if (gesture.type == Gesture<TSize>::Type::PRESS) {
+			mTouched = target(gesture.start);
+		}
+
+		if (mTouched == nullptr) {
+			return;
+		}
+
+		if (gesture.type == Gesture<TSize>::Type::TAP) {
+			mTouched->propagateClick(gesture.point);
+		}
+
+		mTouched->propagateGesture(gesture);
+	}
+
+	/**
+	 * @brief Gesture recognizer, e.g. to adjust the gesture thresholds.
+	 */
+	inline GestureRecognizer<TSize> &gestures ()
+	{
+		return mGestures;
 	}
 
+	/**
+	 * @brief Delivers the click to the active widget, or, if it is a popup
+	 * not containing the point, according to its modality.
+	 */
 	void onClick (Point<TSize> point)
 	{
-		mStack.top()->propagateClick(point);
+		Widget<TPixel, TSize> *widget = target(point);
+
+		if (widget) {
+			widget->propagateClick(point);
+		}
+	}
+
+	/**
+	 * @brief Returns the sprites shown over all the layers, e.g. a cursor or
+	 * a dragged item. Changes to the sprites are shown on the next frame.
+	 */
+	inline Overlay<TPixel, TSize> &overlay ()
+	{
+		return mOverlay;
 	}
 
 	inline TSize width () const
@@ -64,8 +347,366 @@ public:
 	}
 
 private:
-	std::stack<Widget<TPixel, TSize> *> mStack;
+	struct Layer;
+
+	void add (Layer layer)
+	{
+		animate(layer.widget->geometry(), layer.transition, [this, &layer]() {
+			mLayers.push_back(std::move(layer));
+			mLayers.back().widget->update();
+		});
+	}
+
+	/**
+	 * @brief Finds the widget receiving the touch at the given point. Touches
+	 * outside of the popups are passed to the layers behind, ignored, or close
+	 * the popups, depending on their modality.
+	 * @return The widget, or nullptr if the touch is ignored.
+	 */
+	Widget<TPixel, TSize> *target (Point<TSize> point)
+	{
+		for (size_t i = mLayers.size(); i-- > 0; ) {
+			Layer &layer = mLayers[i];
+
+			if (!layer.popup || layer.widget->geometry().contains(point)) {
+				return layer.widget;
+			}
+
+			if (layer.modality == Modality::MODAL) {
+				return nullptr;
+			}
+
+			if (layer.modality == Modality::DISMISS) {
+				// Popups opened over it are closed with it.
+				while (mLayers.size() > i) {
+					pop();
+				}
+				return nullptr;
+			}
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * @brief Snapshot mode of the popups, which always save the pixels under
+	 * them.
+	 */
+	inline SnapshotMode saveUnderMode () const
+	{
+		return mSnapshotMode == SnapshotMode::NONE ? SnapshotMode::FULL : mSnapshotMode;
+	}
+
+	/**
+	 * @brief Removes the top layer, and schedules the area it covered to be
+	 * restored from its snapshot, or repainted.
+	 */
+	void remove ()
+	{
+		Rectangle<TSize> area = mLayers.back().widget->geometry();
+
+		if (mTouched == mLayers.back().widget) {
+			mTouched = nullptr;
+		}
+
+		if (mLayers.back().snapshot.valid()) {
+			mRestores.push_back(std::move(mLayers.back().snapshot));
+			mLayers.pop_back();
+			return;
+		}
+
+		mLayers.pop_back();
+
+		for (auto &layer : mLayers) {
+			Rectangle<TSize> uncovered = area.intersected(layer.widget->geometry());
+
+			if (!uncovered.isEmpty()) {
+				layer.widget->expose(uncovered);
+			}
+		}
+	}
+
+	/**
+	 * @brief Applies the change of the layers, animated with the transition
+	 * if one is set. The area is painted offscreen, as it is before and after
+	 * the change, and the transition then composes the frames from the two
+	 * images, leaving the widgets with no damage to repaint.
+	 */
+	template<typename TChange>
+	void animate (Rectangle<TSize> area, TransitionType type, TChange change)
+	{
+		if (mTransition) {
+			frame(mTransition->area(), [this]() {
+				finishTransition();
+			});
+		}
+
+		area = area.intersected(Rectangle<TSize> { 0, 0, mDevice->width(), mDevice->height() });
+
+		if (type == TransitionType::NONE || mLayers.empty() || area.isEmpty()) {
+			change();
+			return;
+		}
+
+		// Offscreen images are painted from the widgets, and the snapshots
+		// are taken from the device, so it has to be up to date, and free of
+		// the sprites.
+		frame(Rectangle<TSize> { 0, 0, mDevice->width(), mDevice->height() }, [this]() {
+			paintLayers(Clock::time_point::max());
+		});
+
+		auto from = render(area);
+
+		change();
+
+		if (!mLayers.empty() && mLayers.back().snapshotMode != SnapshotMode::NONE) {
+			frame(mLayers.back().widget->geometry(), [this]() {
+				capture(mLayers.size() - 1);
+			});
+		}
+
+		auto to = render(area);
+
+		mRestores.clear();
+		for (auto &layer : mLayers) {
+			layer.widget->discardDamage();
+		}
+
+		mTransition = std::make_unique<Transition<TPixel, TSize>>(type, mTransitionTime, from, to, area);
+	}
+
+	/**
+	 * @brief Paints the area of the layers to an offscreen surface.
+	 */
+	std::shared_ptr<MemoryDevice<TPixel, TSize>> render (const Rectangle<TSize> &area)
+	{
+		auto surface = std::make_shared<MemoryDevice<TPixel, TSize>>(area);
+		Painter<TPixel, TSize> painter(surface);
+
+		painter.clip(area);
+
+		for (size_t i = 0; i < mLayers.size(); ++i) {
+			if (!covered(i)) {
+				mLayers[i].widget->paint(painter, area);
+			}
+		}
+
+		return surface;
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the areas the next frame is
+	 * going to paint.
+	 */
+	Rectangle<TSize> damage () const
+	{
+		Rectangle<TSize> damage = mTransition ? mTransition->area() : Rectangle<TSize> { 0, 0, 0, 0 };
+
+		for (const auto &snapshot : mRestores) {
+			damage = damage.united(snapshot.area());
+		}
+
+		for (const auto &layer : mLayers) {
+			damage = damage.united(layer.widget->damage());
+		}
+
+		return damage;
+	}
+
+	/**
+	 * @brief Runs the painting of the area, with the sprites lifted off the
+	 * device if they are in the way (or have changed), and dropped onto it
+	 * again after. Double buffered devices are flushed instead, with the
+	 * area the sprites changed as well.
+	 */
+	template<typename TPaint>
+	void frame (const Rectangle<TSize> &area, TPaint paint)
+	{
+		if (mPainting) {
+			paint();
+			return;
+		}
+
+		bool composited = mDevice->doubleBuffered();
+		bool lifted     = !composited && (mOverlay.changed() || mOverlay.intersects(area));
+		Rectangle<TSize> flushed = area.united(mOverlay.damage()).intersected(
+			Rectangle<TSize> { 0, 0, mDevice->width(), mDevice->height() });
+
+		mPainting = true;
+
+		if (lifted) {
+			mOverlay.lift(*mDevice);
+		}
+
+		paint();
+
+		if (lifted) {
+			mOverlay.drop(*mDevice);
+		}
+
+		mPainting = false;
+
+		if (!flushed.isEmpty()) {
+			mDevice->flush(flushed, mOverlay);
+		}
+
+		if (composited) {
+			mOverlay.composed();
+		}
+	}
+
+	/**
+	 * @brief Paints the last frame of the running transition at once.
+	 */
+	void finishTransition ()
+	{
+		if (mTransition) {
+			mTransition->finish(*mDevice);
+			mTransition.reset();
+		}
+	}
+
+	/**
+	 * @brief Dispatches the queued input, and reports the drags and the long
+	 * presses recognized since the last frame.
+	 */
+	void dispatchEvents ()
+	{
+		auto callback = [this](const Gesture<TSize> &gesture) {
+			onGesture(gesture);
+		};
+
+		mDevice->dispatchEvents();
+		mGestures.flush(callback);
+		mGestures.update(Clock::now(), callback);
+	}
+
+	/**
+	 * @brief Restores the snapshots of the popped widgets, and repaints the
+	 * damaged areas of the widgets, starting with the bottom one. Widgets on
+	 * top are painted again over the repainted areas.
+	 */
+	void paintLayers (typename Clock::time_point deadline)
+	{
+		for (const auto &snapshot : mRestores) {
+			snapshot.restore(*mDevice);
+		}
+		mRestores.clear();
+
+		for (size_t i = 0; i < mLayers.size(); ++i) {
+			Widget<TPixel, TSize> *widget = mLayers[i].widget;
+
+			if (!widget->damaged()) {
+				continue;
+			}
+
+			Rectangle<TSize> damage = widget->damage();
+
+			dropSnapshots(i, damage);
+
+			if (covered(i)) {
+				// Hidden widget is repainted once uncovered.
+				widget->discardDamage();
+				continue;
+			}
+
+			if (mLayers[i].snapshotMode != SnapshotMode::NONE) {
+				capture(i);
+			}
+
+			widget->paintDamaged(mPainter, deadline);
+
+			for (size_t j = i + 1; j < mLayers.size(); ++j) {
+				Rectangle<TSize> area = damage.intersected(mLayers[j].widget->geometry());
+
+				if (!area.isEmpty()) {
+					mLayers[j].widget->expose(area);
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Takes the snapshot of the pixels the widget is about to cover.
+	 * Given up if the widgets behind are not completely painted.
+	 */
+	void capture (size_t index)
+	{
+		Layer &layer = mLayers[index];
+
+		for (size_t i = 0; i < index; ++i) {
+			if (mLayers[i].widget->damaged()) {
+				layer.snapshotMode = SnapshotMode::NONE;
+				return;
+			}
+		}
+
+		layer.snapshot.capture(*mDevice, layer.widget->geometry(), layer.snapshotMode);
+		layer.snapshotMode = SnapshotMode::NONE;
+	}
+
+	/**
+	 * @brief Drops the snapshots of the widgets above the given one, that
+	 * would be outdated by repainting the area.
+	 */
+	void dropSnapshots (size_t index, const Rectangle<TSize> &area)
+	{
+		for (size_t i = index + 1; i < mLayers.size(); ++i) {
+			if (mLayers[i].snapshot.valid() && mLayers[i].snapshot.area().intersects(area)) {
+				mLayers[i].snapshot.clear();
+			}
+		}
+	}
+
+	/**
+	 * @brief Checks whether the widget is hidden behind an opaque widget
+	 * pushed after it.
+	 */
+	bool covered (size_t index) const
+	{
+		Rectangle<TSize> geometry = mLayers[index].widget->geometry();
+
+		for (size_t i = index + 1; i < mLayers.size(); ++i) {
+			const Widget<TPixel, TSize> *widget = mLayers[i].widget;
+
+			if (widget->opaque() && widget->geometry().covers(geometry)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	struct Layer
+	{
+		Widget<TPixel, TSize> *widget;
+		bool popup;
+		Modality modality;
+		// Transition played when pushed, and reversed when popped.
+		TransitionType transition;
+		// Snapshot to take on the first paint, NONE once taken.
+		SnapshotMode snapshotMode;
+		Snapshot<TPixel, TSize> snapshot;
+		// Owned widget is declared last, so it is destroyed before its arena.
+		std::unique_ptr<Arena> arena;
+		std::unique_ptr<Widget<TPixel, TSize>> owned;
+	};
+
+	std::vector<Layer> mLayers;
+	std::vector<Snapshot<TPixel, TSize>> mRestores;
+	Overlay<TPixel, TSize> mOverlay;
+	bool mPainting = false;
+	SnapshotMode mSnapshotMode = SnapshotMode::NONE;
+	std::unique_ptr<Transition<TPixel, TSize>> mTransition;
+	TransitionType mTransitionType = TransitionType::NONE;
+	typename Clock::duration mTransitionTime = std::chrono::milliseconds(250);
+	Widget<TPixel, TSize> *mTouched = nullptr;
 	std::shared_ptr<Device<TPixel>> mDevice;
+	Painter<TPixel, TSize> mPainter;
+	GestureRecognizer<TSize> mGestures;
+	typename Clock::time_point mLastFrame;
+	typename Clock::duration mFrameInterval = std::chrono::milliseconds(16);
+	typename Clock::duration mFrameBudget   = std::chrono::milliseconds(12);
 };
 
 } /* namespace maligui */
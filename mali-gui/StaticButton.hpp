@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Alignment.hpp"
+#include "Font.hpp"
+#include "FontDatabase.hpp"
+#include "Painter.hpp"
+#include "Point.hpp"
+#include "Rectangle.hpp"
+#include "Widget.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize = int>
+/**
+ * @brief The StaticButton class is a push button for the StaticScreen. Unlike
+ * the Button, it is not a Widget: it has no children, no virtual methods and
+ * does not own its text, so it takes no heap and can be declared, geometry
+ * included, at compile time.
+ *
+ * Changing the button only invalidates its area of the screen it belongs to.
+ */
+class StaticButton
+{
+public:
+	/**
+	 * @brief Click handler. Called with the context given to the button.
+	 */
+	typedef bool (*Handler)(void *context, StaticButton &button, const Point<TSize> &p);
+
+	/**
+	 * @param geometry   Button geometry, e.g. computed with gridCell().
+	 * @param text       Button label, not copied.
+	 * @param background Background color.
+	 * @param foreground Text and border color.
+	 * @param handler    Click handler, or nullptr.
+	 * @param context    Passed to the click handler.
+	 */
+	constexpr StaticButton(Rectangle<TSize> geometry,
+	                       const char      *text,
+	                       TPixel           background,
+	                       TPixel           foreground,
+	                       Handler          handler = nullptr,
+	                       void            *context = nullptr) :
+		mGeometry(geometry),
+		mText(text),
+		mBackgroundColor(background),
+		mForegroundColor(foreground),
+		mHandler(handler),
+		mContext(context)
+	{
+	}
+
+	/**
+	 * @brief Renders the button. Painter is set up with the button geometry.
+	 */
+	void paint (Painter<TPixel, TSize> &painter)
+	{
+		if (mFont == nullptr) {
+			mFont = mHasFont ? FontDatabase::get(mFontHandle) : FontDatabase::get();
+		}
+
+		painter.fill(mBackgroundColor);
+		painter.color(mForegroundColor);
+		painter.rect(mGeometry);
+		painter.write(mText, mHorizontalAlign, mVerticalAlign, mFont);
+	}
+
+	bool onClick (const Point<TSize> &p)
+	{
+		if (mHandler) {
+			return mHandler(mContext, *this, p);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Sets the widget the button is painted by, which is invalidated
+	 * when the button changes.
+	 */
+	inline void attach (Widget<TPixel, TSize> *screen)
+	{
+		mScreen = screen;
+	}
+
+	constexpr const Rectangle<TSize> &geometry () const
+	{
+		return mGeometry;
+	}
+
+	constexpr const char *text () const
+	{
+		return mText;
+	}
+
+	/**
+	 * @brief Sets the label. The text is not copied, so it has to outlive the
+	 * button (or the next call).
+	 */
+	void text (const char *text)
+	{
+		mText = text;
+		update();
+	}
+
+	void backgroundColor (TPixel color)
+	{
+		mBackgroundColor = color;
+		update();
+	}
+
+	void foregroundColor (TPixel color)
+	{
+		mForegroundColor = color;
+		update();
+	}
+
+	void setFont (FontHandle handle)
+	{
+		mFontHandle = handle;
+		mHasFont    = true;
+		mFont       = nullptr;
+		update();
+	}
+
+	void horizontalAlign (align::Horizontal align)
+	{
+		mHorizontalAlign = align;
+		update();
+	}
+
+	void verticalAlign (align::Vertical align)
+	{
+		mVerticalAlign = align;
+		update();
+	}
+
+	/**
+	 * @brief Schedules the button for repainting.
+	 */
+	void update ()
+	{
+		if (mScreen) {
+			mScreen->invalidate(mGeometry);
+		}
+	}
+
+private:
+	Rectangle<TSize> mGeometry;
+	const char *mText;
+	TPixel mBackgroundColor;
+	TPixel mForegroundColor;
+	Handler mHandler;
+	void *mContext;
+	FontHandle mFontHandle { "", 0 };
+	bool mHasFont      = false;
+	const Font *mFont  = nullptr;
+	align::Horizontal mHorizontalAlign = align::Horizontal::CENTER;
+	align::Vertical mVerticalAlign     = align::Vertical::CENTER;
+	Widget<TPixel, TSize> *mScreen     = nullptr;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <tuple>
+#include <utility>
+
+#include "Painter.hpp"
+#include "Point.hpp"
+#include "Rectangle.hpp"
+#include "Widget.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize, typename ... TWidgets>
+/**
+ * @brief The StaticScreen class is a screen whose structure is fixed at
+ * compile time. It holds its widgets by value, in a tuple, so the whole screen
+ * is a single object (e.g. a static variable) that takes no heap. Widgets are
+ * painted and hit tested through static dispatch, in the order they are given.
+ * An std::array of widgets can be used in place of a single widget, e.g. for a
+ * keypad.
+ *
+ * Static widgets (see StaticButton) provide geometry(), paint(Painter &),
+ * onClick(const Point &) and attach(Widget *). Their geometry is given on
+ * construction, and can be computed at compile time with gridCell().
+ *
+ * The screen itself is a Widget, so it is pushed to the Stacker like any other
+ * screen, and can also have the regular (dynamic) children, which are painted
+ * on top of the static ones.
+ */
+class StaticScreen : public Widget<TPixel, TSize>
+{
+public:
+	StaticScreen(Rectangle<TSize> geometry, TWidgets ... widgets) :
+		Widget<TPixel, TSize>(geometry),
+		mWidgets(widgets ...)
+	{
+		forEach([this](auto &widget) {
+			widget.attach(this);
+			return false;
+		});
+	}
+
+	/**
+	 * @brief Returns the static widget at the given position.
+	 */
+	template<size_t I>
+	auto &get ()
+	{
+		return std::get<I>(mWidgets);
+	}
+
+	/**
+	 * @brief Paints the static widgets intersecting the painted area, and
+	 * then the dynamic children.
+	 */
+	virtual void onPaint (Painter<TPixel, TSize> &painter) override
+	{
+		Rectangle<TSize> clip = painter.clip();
+
+		forEach([&painter, &clip](auto &widget) {
+			Rectangle<TSize> area = clip.intersected(widget.geometry());
+
+			if (!area.isEmpty()) {
+				auto state = painter.save();
+
+				painter.geometry(widget.geometry());
+				painter.clip(area);
+				widget.paint(painter);
+				painter.restore(state);
+			}
+
+			return false;
+		});
+
+		Widget<TPixel, TSize>::onPaint(painter);
+	}
+
+	/**
+	 * @brief Delivers the click to the first static widget containing it,
+	 * and, unless its handler returns false, to the screen itself.
+	 */
+	virtual bool onClick (const Point<TSize> &p) override
+	{
+		bool handle = true;
+
+		forEach([&p, &handle](auto &widget) {
+			Rectangle<TSize> geometry = widget.geometry();
+
+			if (!geometry.contains(p)) {
+				return false;
+			}
+
+			handle = widget.onClick(p);
+
+			return true;
+		});
+
+		if (handle) {
+			handle = Widget<TPixel, TSize>::onClick(p);
+		}
+
+		return handle;
+	}
+
+private:
+	/**
+	 * @brief Calls the callback for each static widget, in order, until it
+	 * returns true.
+	 */
+	template<typename TCallback>
+	void forEach (TCallback callback)
+	{
+		forEach(callback, std::index_sequence_for<TWidgets ...>());
+	}
+
+	template<typename TCallback, size_t ... I>
+	void forEach (TCallback &callback, std::index_sequence<I ...>)
+	{
+		bool done = false;
+
+		// Braced initializer list is evaluated in order.
+		(void) std::initializer_list<int> {
+			0, (done = done || visit(callback, std::get<I>(mWidgets)), 0) ...
+		};
+	}
+
+	template<typename TCallback, typename TWidget>
+	static bool visit (TCallback &callback, TWidget &widget)
+	{
+		return callback(widget);
+	}
+
+	template<typename TCallback, typename TWidget, size_t N>
+	static bool visit (TCallback &callback, std::array<TWidget, N> &widgets)
+	{
+		for (auto &widget : widgets) {
+			if (callback(widget)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	std::tuple<TWidgets ...> mWidgets;
+};
+
+} /* namespace maligui */
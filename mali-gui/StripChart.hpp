@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Arena.hpp"
+#include "Painter.hpp"
+#include "Rectangle.hpp"
+#include "Widget.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize = int, typename TSample = int>
+/**
+ * @brief The StripChart class plots a stream of samples, e.g. live sensor
+ * readings, scrolling from right to left. Each pixel column shows a fixed
+ * number of samples as the vertical span from their minimum to their maximum,
+ * so fast signals keep their peaks however many samples a column holds. The
+ * rightmost column shows the samples of the column still being filled.
+ *
+ * Completed columns are kept in a ring buffer, one per column of the plot,
+ * which is all the history the chart stores. Like the ListView, the chart
+ * moves its pixels on the device: when columns are added, the plot is moved
+ * left with Device::copyRect(), and only the new columns are painted. The
+ * frame and the history are not painted again until the chart is updated.
+ * A chart under popups or other widgets has to be cached (see
+ * Widget::cached()), so its pixels are moved offscreen instead.
+ */
+class StripChart : public Widget<TPixel, TSize>
+{
+public:
+	StripChart(Rectangle<TSize> geometry = { 0, 0, 0, 0 }) :
+		StripChart(nullptr, geometry)
+	{
+	}
+
+	/**
+	 * @brief Creates the chart, with its history allocated from the arena.
+	 */
+	explicit StripChart(Arena *arena, Rectangle<TSize> geometry = { 0, 0, 0, 0 }) :
+		Widget<TPixel, TSize>(arena, geometry),
+		mColumns(ArenaAllocator<Column>(arena))
+	{
+		this->opaque(true);
+	}
+
+	/**
+	 * @brief Adds the sample. Columns are scrolled in once painted, so any
+	 * number of samples can be added between the frames.
+	 */
+	void append (TSample sample)
+	{
+		// Each column continues from the last sample of the previous one, so
+		// the plot has no gaps.
+		TSample first = mFilled || !mStarted ? sample : mLast;
+
+		if (mFilled == 0) {
+			mCurrent = Column { std::min(first, sample), std::max(first, sample) };
+		} else {
+			mCurrent.minimum = std::min(mCurrent.minimum, sample);
+			mCurrent.maximum = std::max(mCurrent.maximum, sample);
+		}
+
+		mLast    = sample;
+		mStarted = true;
+
+		if (++mFilled == mSamplesPerColumn) {
+			push(mCurrent);
+			mFilled = 0;
+
+			// Pixels of the whole plot are moved, once the first column since
+			// the last frame is completed.
+			if (++mScrolled == 1) {
+				this->invalidate(plot());
+			}
+		} else if (!this->mDirty) {
+			Rectangle<TSize> plot = this->plot();
+
+			this->invalidate(Rectangle<TSize> { plot.x + plot.width - 1, plot.y, 1, plot.height });
+		}
+	}
+
+	void append (const TSample *samples, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i) {
+			append(samples[i]);
+		}
+	}
+
+	/**
+	 * @brief Removes all the samples.
+	 */
+	void clear ()
+	{
+		mSize    = 0;
+		mFilled  = 0;
+		mStarted = false;
+		update();
+	}
+
+	/**
+	 * @brief Sets the number of samples shown by each column, e.g. 4 for the
+	 * 1 kHz samples scrolling by 250 pixels a second.
+	 */
+	void samplesPerColumn (size_t count)
+	{
+		mSamplesPerColumn = count > 0 ? count : 1;
+		mFilled = std::min(mFilled, mSamplesPerColumn - 1);
+	}
+
+	inline size_t samplesPerColumn () const
+	{
+		return mSamplesPerColumn;
+	}
+
+	/**
+	 * @brief Sets the values shown at the bottom and at the top of the plot.
+	 * Samples out of the range are clamped to it.
+	 */
+	void range (TSample minimum, TSample maximum)
+	{
+		mMinimum = minimum;
+		mMaximum = maximum;
+		update();
+	}
+
+	/**
+	 * @brief Sets the number of horizontal grid lines, spread evenly over
+	 * the plot.
+	 */
+	void gridLines (int count)
+	{
+		mGridLines = count;
+		update();
+	}
+
+	void backgroundColor (const TPixel &color)
+	{
+		mBackground = color;
+		update();
+	}
+
+	void foregroundColor (const TPixel &color)
+	{
+		mForeground = color;
+		update();
+	}
+
+	void borderColor (const TPixel &color)
+	{
+		mBorder = color;
+		update();
+	}
+
+	void gridColor (const TPixel &color)
+	{
+		mGrid = color;
+		update();
+	}
+
+	virtual void update () override
+	{
+		mRepaint = true;
+		Widget<TPixel, TSize>::update();
+	}
+
+	virtual void onPaint (Painter<TPixel, TSize> &painter) override
+	{
+		Rectangle<TSize> plot = this->plot();
+		Rectangle<TSize> clip = painter.clip();
+		TSize right = plot.x + plot.width - 1;
+		TSize first = plot.x;
+		bool kept = (this->ownPixels() || this->cached()) && !mRepaint &&
+		            painter.device() == mSurface && this->mGeometry == mPainted;
+
+		fit();
+
+		if (kept && mScrolled < size_t(plot.width) && (mScrolled == 0 || clip.covers(plot))) {
+			// Columns completed since the last frame, and the one in progress.
+			first    = right - TSize(mScrolled);
+			mRepaint = false;
+
+			if (mScrolled > 0) {
+				painter.scroll(plot, -TSize(mScrolled), 0);
+			}
+		} else {
+			painter.fill(mBackground);
+			painter.color(mBorder);
+			painter.rect(this->mGeometry);
+
+			// Pixels outside of the clip are left as they were, so the chart
+			// is painted as a whole next time.
+			mRepaint = !clip.covers(this->mGeometry);
+		}
+
+		mSurface  = painter.device();
+		mPainted  = this->mGeometry;
+		mScrolled = 0;
+
+		for (TSize x = first; x <= right; ++x) {
+			paintColumn(painter, plot, x, size_t(right - x));
+		}
+	}
+
+private:
+	struct Column {
+		TSample minimum;
+		TSample maximum;
+	};
+
+	/**
+	 * @brief Returns the plot area, inside of the frame.
+	 */
+	inline Rectangle<TSize> plot () const
+	{
+		const Rectangle<TSize> &g = this->mGeometry;
+
+		return Rectangle<TSize> { g.x + 1, g.y + 1,
+		                          std::max(TSize(0), g.width - 2),
+		                          std::max(TSize(0), g.height - 2) };
+	}
+
+	/**
+	 * @brief Sizes the ring buffer to the plot width, keeping the newest
+	 * columns.
+	 */
+	void fit ()
+	{
+		size_t capacity = size_t(plot().width);
+
+		if (capacity == mColumns.size()) {
+			return;
+		}
+
+		std::vector<Column, ArenaAllocator<Column>> columns(capacity, Column {},
+		                                                     mColumns.get_allocator());
+		size_t size = std::min(mSize, capacity);
+
+		for (size_t i = 0; i < size; ++i) {
+			columns[size - 1 - i] = column(i);
+		}
+
+		mColumns.swap(columns);
+		mSize = size;
+		mHead = capacity ? size % capacity : 0;
+	}
+
+	inline void push (const Column &column)
+	{
+		fit();
+
+		if (mColumns.empty()) {
+			return;
+		}
+
+		mColumns[mHead] = column;
+		mHead = (mHead + 1) % mColumns.size();
+		mSize = std::min(mSize + 1, mColumns.size());
+	}
+
+	/**
+	 * @brief Returns the completed column, 0 being the newest one.
+	 */
+	inline const Column &column (size_t age) const
+	{
+		return mColumns[(mHead + mColumns.size() - 1 - age) % mColumns.size()];
+	}
+
+	/**
+	 * @brief Returns the vertical position of the value, within the plot.
+	 */
+	inline TSize position (const Rectangle<TSize> &plot, TSample value) const
+	{
+		if (mMaximum <= mMinimum) {
+			return plot.y + plot.height - 1;
+		}
+
+		value = std::max(mMinimum, std::min(value, mMaximum));
+
+		return plot.y + plot.height - 1 -
+		       TSize((value - mMinimum) * (plot.height - 1) / (mMaximum - mMinimum));
+	}
+
+	/**
+	 * @brief Paints the column of the plot, at the given distance from its
+	 * right edge: the column in progress at 0, and the completed ones
+	 * further left.
+	 */
+	void paintColumn (Painter<TPixel, TSize> &painter,
+	                  const Rectangle<TSize> &plot,
+	                  TSize                   x,
+	                  size_t                  distance)
+	{
+		painter.fill(Rectangle<TSize> { x, plot.y, 1, plot.height }, mBackground);
+
+		for (int i = 1; i <= mGridLines; ++i) {
+			painter.point(x, plot.y + TSize(plot.height * i / (mGridLines + 1)), mGrid);
+		}
+
+		const Column *column = nullptr;
+
+		if (distance == 0) {
+			column = mFilled ? &mCurrent : nullptr;
+		} else if (distance <= mSize) {
+			column = &this->column(distance - 1);
+		}
+
+		if (column) {
+			TSize top    = position(plot, column->maximum);
+			TSize bottom = position(plot, column->minimum);
+
+			painter.fill(Rectangle<TSize> { x, top, 1, bottom - top + 1 }, mForeground);
+		}
+	}
+
+	/**
+	 * @brief Completed columns, mSize of them, the newest before mHead.
+	 */
+	std::vector<Column, ArenaAllocator<Column>> mColumns;
+	size_t mHead = 0;
+	size_t mSize = 0;
+
+	/**
+	 * @brief Column in progress, holding mFilled samples.
+	 */
+	Column mCurrent {};
+	size_t mFilled           = 0;
+	size_t mSamplesPerColumn = 1;
+	TSample mLast {};
+	bool mStarted = false;
+
+	TSample mMinimum {};
+	TSample mMaximum {};
+	int mGridLines = 0;
+	TPixel mBackground {};
+	TPixel mForeground {};
+	TPixel mBorder {};
+	TPixel mGrid {};
+
+	/**
+	 * @brief State of the pixels on the device: the device itself, the
+	 * geometry the chart was painted with, and the columns completed since.
+	 */
+	const Device<TPixel, TSize> *mSurface = nullptr;
+	Rectangle<TSize> mPainted { 0, 0, 0, 0 };
+	size_t mScrolled = 0;
+	bool mRepaint    = true;
+};
+
+} /* namespace maligui */
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+
+#include "Alignment.hpp"
+#include "Arena.hpp"
+#include "Font.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel>
+/**
+ * @brief The Style struct describes the look of a widget. Styles are meant to
+ * be shared by many widgets, which only keep a pointer to them, so a style
+ * must outlive the widgets using it (e.g. be a static object).
+ */
+struct Style {
+	TPixel background;
+	TPixel foreground;
+	TPixel border;
+
+	/**
+	 * @brief Font of the text, nullptr for the widget's default.
+	 */
+	const Font *font;
+
+	align::Horizontal horizontalAlign;
+	align::Vertical verticalAlign;
+};
+
+template<typename TPixel>
+/**
+ * @brief The Theme struct holds the styles used by the widgets that were not
+ * given a style of their own, one per widget class. Switching the theme is a
+ * single pointer assignment, after which the widgets need to be updated (see
+ * Stacker::update()).
+ */
+struct Theme {
+	Style<TPixel> button;
+	Style<TPixel> label;
+
+	static inline const Theme &current ()
+	{
+		return *active();
+	}
+
+	/**
+	 * @brief Makes the theme current. The theme must outlive its use.
+	 */
+	static inline void set (const Theme &theme)
+	{
+		active() = &theme;
+	}
+
+private:
+	static const Theme *&active ()
+	{
+		static const Theme fallback {
+			{ TPixel(), TPixel(), TPixel(), nullptr,
+			  align::Horizontal::CENTER, align::Vertical::CENTER },
+			{ TPixel(), TPixel(), TPixel(), nullptr,
+			  align::Horizontal::LEFT, align::Vertical::TOP }
+		};
+		static const Theme *theme = &fallback;
+
+		return theme;
+	}
+};
+
+template<typename TPixel, Style<TPixel> Theme<TPixel>::*TRole>
+/**
+ * @brief The Styled class holds the style of a single widget: the shared style
+ * (by default, the one the current theme has for the widget class), and the
+ * properties overridden for this widget alone. Overrides are only allocated
+ * once the first one is set, from the arena of the widget, if any, so widgets
+ * using the shared style take just two pointers.
+ */
+class Styled
+{
+public:
+	Styled() = default;
+
+	Styled(const Styled &) = delete;
+	Styled &operator= (const Styled &) = delete;
+
+	~Styled()
+	{
+		if (mOverrides && mOverrides->arena == nullptr) {
+			delete mOverrides;
+		}
+	}
+
+	/**
+	 * @brief Returns the shared style.
+	 */
+	inline const Style<TPixel> &shared () const
+	{
+		return mShared ? *mShared : Theme<TPixel>::current().*TRole;
+	}
+
+	/**
+	 * @brief Sets the shared style, nullptr for the one of the current theme.
+	 */
+	inline void shared (const Style<TPixel> *style)
+	{
+		mShared = style;
+	}
+
+	inline const TPixel &background () const
+	{
+		return get(&Style<TPixel>::background, BACKGROUND);
+	}
+
+	inline void background (const TPixel &color, Arena *arena)
+	{
+		set(&Style<TPixel>::background, BACKGROUND, color, arena);
+	}
+
+	inline const TPixel &foreground () const
+	{
+		return get(&Style<TPixel>::foreground, FOREGROUND);
+	}
+
+	inline void foreground (const TPixel &color, Arena *arena)
+	{
+		set(&Style<TPixel>::foreground, FOREGROUND, color, arena);
+	}
+
+	inline const TPixel &border () const
+	{
+		return get(&Style<TPixel>::border, BORDER);
+	}
+
+	inline void border (const TPixel &color, Arena *arena)
+	{
+		set(&Style<TPixel>::border, BORDER, color, arena);
+	}
+
+	inline const Font *font () const
+	{
+		return get(&Style<TPixel>::font, FONT);
+	}
+
+	inline void font (const Font *font, Arena *arena)
+	{
+		set(&Style<TPixel>::font, FONT, font, arena);
+	}
+
+	inline align::Horizontal horizontalAlign () const
+	{
+		return get(&Style<TPixel>::horizontalAlign, HORIZONTAL_ALIGN);
+	}
+
+	inline void horizontalAlign (align::Horizontal align, Arena *arena)
+	{
+		set(&Style<TPixel>::horizontalAlign, HORIZONTAL_ALIGN, align, arena);
+	}
+
+	inline align::Vertical verticalAlign () const
+	{
+		return get(&Style<TPixel>::verticalAlign, VERTICAL_ALIGN);
+	}
+
+	inline void verticalAlign (align::Vertical align, Arena *arena)
+	{
+		set(&Style<TPixel>::verticalAlign, VERTICAL_ALIGN, align, arena);
+	}
+
+private:
+	enum Property : uint8_t {
+		BACKGROUND       = 1 << 0,
+		FOREGROUND       = 1 << 1,
+		BORDER           = 1 << 2,
+		FONT             = 1 << 3,
+		HORIZONTAL_ALIGN = 1 << 4,
+		VERTICAL_ALIGN   = 1 << 5
+	};
+
+	struct Overrides {
+		Style<TPixel> style;
+		uint8_t set;
+		Arena *arena;
+	};
+
+	template<typename T>
+	inline const T &get (T Style<TPixel>::*property, Property flag) const
+	{
+		if (mOverrides && (mOverrides->set & flag)) {
+			return mOverrides->style.*property;
+		}
+
+		return shared().*property;
+	}
+
+	template<typename T>
+	void set (T Style<TPixel>::*property, Property flag, const T &value, Arena *arena)
+	{
+		if (!mOverrides) {
+			mOverrides = arena
+			             ? new (arena->allocate(sizeof(Overrides), alignof(Overrides)))
+			               Overrides { shared(), 0, arena }
+			             : new Overrides { shared(), 0, nullptr };
+		}
+
+		mOverrides->style.*property = value;
+		mOverrides->set            |= flag;
+	}
+
+	const Style<TPixel> *mShared = nullptr;
+	Overrides *mOverrides        = nullptr;
+};
+
+} /* namespace maligui */
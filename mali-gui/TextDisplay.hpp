@@ -0,0 +1,286 @@
+#pragma once
+
+#include <string>
+
+#include "Alignment.hpp"
+#include "FontDatabase.hpp"
+#include "Painter.hpp"
+#include "Style.hpp"
+#include "Widget.hpp"
+
+namespace maligui
+{
+
+template<typename TPixel, typename TSize = int>
+/**
+ * @brief The TextDisplay class widget shows a single line of text which
+ * changes often, such as a calculator display, a counter or a clock. When the
+ * text is set, it is compared to the previous one, glyph by glyph, and only
+ * the glyphs which changed (or moved) are invalidated, together with the area
+ * the old ones left. Glyphs staying the same at the same place, e.g. the
+ * leading digits of a right aligned counter, or the start of left aligned
+ * text, are not painted again.
+ *
+ * Like the Label, the display takes its look from the label style of the
+ * current Theme, overridden by the properties set on the display itself.
+ */
+class TextDisplay : public Widget<TPixel, TSize>
+{
+public:
+	explicit TextDisplay<TPixel, TSize>(Arena *arena = nullptr) :
+		Widget<TPixel, TSize>(arena) {
+		// Background fills the whole geometry.
+		this->opaque(true);
+	}
+
+	/**
+	 * @brief Renders the display. Only the glyphs within the clip are
+	 * rendered.
+	 */
+	virtual void onPaint (Painter<TPixel, TSize> &painter) override
+	{
+		Rectangle<TSize> clip = painter.clip();
+		const Font *font      = this->font();
+
+		painter.fill(mStyle.background());
+		painter.color(mStyle.border());
+		painter.rect(this->mGeometry);
+		painter.color(mStyle.foreground());
+		painter.setFont(font);
+
+		if (font) {
+			TSize  x     = left(font, mText);
+			size_t first = 0;
+
+			while (first < mText.size() && x + advance(font, mText[first]) <= clip.x) {
+				x += advance(font, mText[first++]);
+			}
+
+			size_t last = first;
+
+			for (TSize end = x; last < mText.size() && end < clip.x + clip.width; ++last) {
+				end += advance(font, mText[last]);
+			}
+
+			painter.write(x, top(font), mText.c_str() + first, last - first);
+		}
+
+		Widget<TPixel, TSize>::onPaint(painter);
+	}
+
+	/**
+	 * @brief Sets the text, and invalidates the glyphs which changed.
+	 */
+	void text (const std::string &text)
+	{
+		if (text == mText) {
+			return;
+		}
+
+		const Font *font = this->font();
+
+		if (font == nullptr) {
+			mText = text;
+			return;
+		}
+
+		Rectangle<TSize> changed = difference(font, mText, text);
+
+		mText = text;
+
+		if (!changed.isEmpty()) {
+			this->invalidate(changed.intersected(this->mGeometry));
+		}
+	}
+
+	const std::string &text () const
+	{
+		return mText;
+	}
+
+	using Widget<TPixel, TSize>::onClickHandler;
+
+	/**
+	 * @brief Sets the click handler, which receives the display itself rather
+	 * than a Widget, e.g. [](TextDisplay<TPixel> *display, Point<int> p) { ... }.
+	 */
+	template<typename TCallable>
+	void onClickHandler (TCallable handler)
+	{
+		this->mClickHandler =
+			Widget<TPixel, TSize>::EventHandler::template downcast<TextDisplay>(handler);
+	}
+
+	/**
+	 * @brief Sets the shared style, nullptr for the label style of the
+	 * current theme. The style must outlive the display.
+	 */
+	void style (const Style<TPixel> *style)
+	{
+		mStyle.shared(style);
+		this->update();
+	}
+
+	const Style<TPixel> &style () const
+	{
+		return mStyle.shared();
+	}
+
+	virtual TPixel backgroundColor ()
+	{
+		return mStyle.background();
+	}
+
+	virtual void backgroundColor (const TPixel color)
+	{
+		mStyle.background(color, this->arena());
+		this->update();
+	}
+
+	virtual TPixel foregroundColor ()
+	{
+		return mStyle.foreground();
+	}
+
+	virtual void foregroundColor (const TPixel color)
+	{
+		mStyle.foreground(color, this->arena());
+		this->update();
+	}
+
+	virtual TPixel borderColor ()
+	{
+		return mStyle.border();
+	}
+
+	virtual void borderColor (const TPixel color)
+	{
+		mStyle.border(color, this->arena());
+		this->update();
+	}
+
+	void setFont (const std::string &name, int size)
+	{
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
+	}
+
+	void setFont (const char *name, int size)
+	{
+		mStyle.font(FontDatabase::get(name, size), this->arena());
+		this->update();
+	}
+
+	void setFont (FontHandle handle)
+	{
+		mStyle.font(FontDatabase::get(handle), this->arena());
+		this->update();
+	}
+
+	void horizontalAlign (align::Horizontal align)
+	{
+		mStyle.horizontalAlign(align, this->arena());
+		this->update();
+	}
+
+	void verticalAlign (align::Vertical align)
+	{
+		mStyle.verticalAlign(align, this->arena());
+		this->update();
+	}
+
+private:
+	inline const Font *font () const
+	{
+		return mStyle.font() ? mStyle.font() : FontDatabase::get();
+	}
+
+	static inline TSize advance (const Font *font, char c)
+	{
+		return TSize(font->character(uint8_t(c)).width());
+	}
+
+	static TSize width (const Font *font, const std::string &text)
+	{
+		TSize width = 0;
+
+		for (char c : text) {
+			width += advance(font, c);
+		}
+
+		return width;
+	}
+
+	/**
+	 * @brief Returns the position of the first glyph of the aligned text.
+	 */
+	TSize left (const Font *font, const std::string &text) const
+	{
+		const Rectangle<TSize> &g = this->mGeometry;
+
+		switch (mStyle.horizontalAlign()) {
+		case align::Horizontal::CENTER:
+			return g.x + (g.width - width(font, text)) / 2;
+		case align::Horizontal::RIGHT:
+			return g.x + g.width - width(font, text);
+		default:
+			return g.x;
+		}
+	}
+
+	TSize top (const Font *font) const
+	{
+		const Rectangle<TSize> &g = this->mGeometry;
+
+		switch (mStyle.verticalAlign()) {
+		case align::Vertical::CENTER:
+			return g.y + (g.height - font->height()) / 2;
+		case align::Vertical::BOTTOM:
+			return g.y + g.height - font->height();
+		default:
+			return g.y;
+		}
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the glyph cells which differ
+	 * between the two texts: the cells of the old glyphs not found at the
+	 * same place in the new text, and the other way around.
+	 */
+	Rectangle<TSize> difference (const Font        *font,
+	                             const std::string &from,
+	                             const std::string &to) const
+	{
+		Rectangle<TSize> changed { 0, 0, 0, 0 };
+		TSize  y     = top(font);
+		TSize  fromX = left(font, from);
+		TSize  toX   = left(font, to);
+		size_t i     = 0;
+		size_t j     = 0;
+
+		// Cells of both texts are walked from left to right, at once.
+		while (i < from.size() || j < to.size()) {
+			if (i < from.size() && j < to.size() && fromX == toX && from[i] == to[j]) {
+				fromX += advance(font, from[i++]);
+				toX   += advance(font, to[j++]);
+			} else if (j == to.size() || (i < from.size() && fromX <= toX)) {
+				TSize w = advance(font, from[i++]);
+
+				changed = changed.united(Rectangle<TSize> { fromX, y, w, font->height() });
+				fromX  += w;
+			} else {
+				TSize w = advance(font, to[j++]);
+
+				changed = changed.united(Rectangle<TSize> { toX, y, w, font->height() });
+				toX    += w;
+			}
+		}
+
+		return changed;
+	}
+
+	std::string mText;
+	Styled<TPixel, &Theme<TPixel>::label> mStyle;
+};
+
+} /* namespace maligui */
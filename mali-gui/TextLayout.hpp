@@ -0,0 +1,391 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Font.hpp"
+
+namespace maligui
+{
+
+template<typename TSize = int>
+/**
+ * @brief The TextLayout class breaks a paragraph of text into lines that fit
+ * the given width. Lines are broken at explicit newlines and, greedily, at
+ * spaces; words that do not fit a line on their own are broken at character
+ * boundaries. When the number of lines is limited, the last visible line can
+ * be truncated with an ellipsis.
+ *
+ * Line breaks are cached. When the text changes, only the lines from the
+ * first edited one are laid out again, and as soon as the new line breaks
+ * realign with the old ones in the unchanged tail of the text, the remaining
+ * lines are reused. This makes appending or editing a single line of a long
+ * text (e.g. a log) cheap.
+ */
+class TextLayout
+{
+public:
+	/**
+	 * @brief A single laid out line. The line spans length characters of the
+	 * text, starting at start. Spaces and newlines at which the line was
+	 * broken are not included.
+	 */
+	struct Line {
+		size_t start;
+		size_t length;
+		TSize  width;
+	};
+
+	TextLayout(const Font *font = nullptr, TSize width = 0) :
+		mFont(font),
+		mWidth(width)
+	{
+	}
+
+	/**
+	 * @brief Sets the text to lay out.
+	 * @param text New text.
+	 * @return Index of the first line that differs from the previous layout.
+	 * Lines before it are unchanged (but may have been reused).
+	 */
+	size_t text (const std::string &text)
+	{
+		size_t oldLength = mText.size();
+		size_t prefix    = 0;
+		size_t suffix    = 0;
+
+		while (prefix < oldLength && prefix < text.size() &&
+		       mText[prefix] == text[prefix]) {
+			++prefix;
+		}
+
+		if (prefix == oldLength && prefix == text.size()) {
+			return mLines.size();
+		}
+
+		while (suffix < oldLength - prefix && suffix < text.size() - prefix &&
+		       mText[oldLength - suffix - 1] == text[text.size() - suffix - 1]) {
+			++suffix;
+		}
+
+		mText = text;
+
+		return reflow(prefix, text.size() - suffix, text.size() - oldLength);
+	}
+
+	inline const std::string &text () const
+	{
+		return mText;
+	}
+
+	void font (const Font *font)
+	{
+		if (font != mFont) {
+			mFont = font;
+			invalidate();
+		}
+	}
+
+	inline const Font *font () const
+	{
+		return mFont;
+	}
+
+	/**
+	 * @brief Sets the width available to the lines, in pixels.
+	 */
+	void width (TSize width)
+	{
+		if (width != mWidth) {
+			mWidth = width;
+			invalidate();
+		}
+	}
+
+	inline TSize width () const
+	{
+		return mWidth;
+	}
+
+	/**
+	 * @brief Sets the additional space between the lines, in pixels.
+	 */
+	inline void lineSpacing (TSize spacing)
+	{
+		mLineSpacing = spacing;
+	}
+
+	inline TSize lineSpacing () const
+	{
+		return mLineSpacing;
+	}
+
+	/**
+	 * @brief Limits the number of visible lines. If the text needs more lines,
+	 * the last visible one is truncated with an ellipsis.
+	 * @param count Maximum number of lines, 0 for no limit.
+	 */
+	inline void maxLines (size_t count)
+	{
+		mMaxLines = count;
+	}
+
+	inline size_t maxLines () const
+	{
+		return mMaxLines;
+	}
+
+	/**
+	 * @brief Distance between the tops of the two consecutive lines.
+	 */
+	inline TSize lineHeight () const
+	{
+		return (mFont ? mFont->height() : 0) + mLineSpacing;
+	}
+
+	/**
+	 * @brief Returns all the laid out lines, including the ones hidden due to
+	 * the maxLines limit.
+	 */
+	inline const std::vector<Line> &lines () const
+	{
+		return mLines;
+	}
+
+	inline size_t visibleLines () const
+	{
+		return mMaxLines && mLines.size() > mMaxLines ? mMaxLines : mLines.size();
+	}
+
+	/**
+	 * @brief Checks whether the last visible line is truncated.
+	 */
+	inline bool elided () const
+	{
+		return visibleLines() < mLines.size();
+	}
+
+	/**
+	 * @brief Height of the visible lines, in pixels.
+	 */
+	inline TSize height () const
+	{
+		size_t count = visibleLines();
+
+		return count ? count * lineHeight() - mLineSpacing : 0;
+	}
+
+	/**
+	 * @brief Returns the visible line at the given index. If the line is the
+	 * last one and the text is elided, the line is shortened so that the
+	 * ellipsis fits the width.
+	 */
+	Line visibleLine (size_t index) const
+	{
+		Line line = mLines.at(index);
+
+		if (!elided() || index + 1 != visibleLines()) {
+			return line;
+		}
+
+		TSize available = mWidth - measure(ELLIPSIS);
+
+		while (line.length > 0 && line.width > available) {
+			--line.length;
+			line.width -= glyphWidth(mText[line.start + line.length]);
+		}
+
+		return line;
+	}
+
+	/**
+	 * @brief Width of the given text, on a single line.
+	 */
+	TSize measure (const char *text) const
+	{
+		TSize width = 0;
+
+		for (; *text != '\0'; ++text) {
+			width += glyphWidth(*text);
+		}
+
+		return width;
+	}
+
+	static constexpr const char *ELLIPSIS = "...";
+
+private:
+	inline TSize glyphWidth (char ch) const
+	{
+		return mFont ? mFont->character(ch).width() : 0;
+	}
+
+	void invalidate ()
+	{
+		mLines.clear();
+		reflow(0, mText.size(), 0);
+	}
+
+	/**
+	 * @brief Lays out the lines again, reusing the old ones where possible.
+	 * @param changeStart First changed character (same in old and new text).
+	 * @param changeEnd   End of the changed characters in the new text.
+	 * @param delta       Change of the text length.
+	 * @return Index of the first changed line.
+	 */
+	size_t reflow (size_t changeStart, size_t changeEnd, ptrdiff_t delta)
+	{
+		// Find the line containing the start of the edited word, which may be
+		// on an earlier line if the word was broken at character boundaries.
+		// Greedy line breaking depends on the first word of the next line, so
+		// an edit of that word can also change the line before.
+		size_t word  = wordStart(changeStart);
+		size_t first = 0;
+
+		while (first < mLines.size() && next(first) <= word) {
+			++first;
+		}
+
+		if (first > 0 && first < mLines.size() &&
+		    firstWordEnd(mLines[first].start) >= word) {
+			--first;
+		}
+
+		std::vector<Line> tail(mLines.begin() + first, mLines.end());
+		size_t tailIndex = 0;
+		size_t pos = first < mLines.size() ? mLines[first].start : 0;
+
+		mLines.resize(first);
+
+		while (pos < mText.size()) {
+			// Once past the change, the lines starting at the same position
+			// (in the unchanged tail of the text) are the same as before.
+			if (pos >= changeEnd) {
+				while (tailIndex < tail.size() &&
+				       static_cast<ptrdiff_t>(tail[tailIndex].start) + delta < static_cast<ptrdiff_t>(pos)) {
+					++tailIndex;
+				}
+
+				if (tailIndex < tail.size() &&
+				    static_cast<ptrdiff_t>(tail[tailIndex].start) + delta == static_cast<ptrdiff_t>(pos)) {
+					for (; tailIndex < tail.size(); ++tailIndex) {
+						Line line = tail[tailIndex];
+						line.start += delta;
+						mLines.push_back(line);
+					}
+					break;
+				}
+			}
+
+			pos = layoutLine(pos);
+		}
+
+		// Lines laid out again may still be the same as before, if they end
+		// before the change.
+		size_t changed = first;
+
+		while (changed < mLines.size() && changed - first < tail.size() &&
+		       mLines[changed].start + mLines[changed].length < changeStart &&
+		       mLines[changed].start == tail[changed - first].start &&
+		       mLines[changed].length == tail[changed - first].length) {
+			++changed;
+		}
+
+		return changed;
+	}
+
+	/**
+	 * @brief Lays out a single line, starting at the given position.
+	 * @return Start of the next line.
+	 */
+	size_t layoutLine (size_t pos)
+	{
+		TSize  x          = 0;
+		size_t breakEnd   = std::string::npos;
+		TSize  breakWidth = 0;
+		size_t i          = pos;
+
+		for (; i < mText.size(); ++i) {
+			char ch = mText[i];
+
+			if (ch == '\n') {
+				mLines.push_back(Line { pos, i - pos, x });
+				return i + 1;
+			}
+
+			// Break at the first of the consecutive spaces, but never at the
+			// start of the line, so that indentation is kept.
+			if (ch == ' ' && i > pos && mText[i - 1] != ' ') {
+				breakEnd   = i;
+				breakWidth = x;
+			}
+
+			TSize width = glyphWidth(ch);
+
+			if (x + width > mWidth && i > pos) {
+				if (breakEnd == std::string::npos) {
+					// Word does not fit on a line of its own.
+					mLines.push_back(Line { pos, i - pos, x });
+					return i;
+				}
+
+				mLines.push_back(Line { pos, breakEnd - pos, breakWidth });
+
+				size_t nextStart = breakEnd;
+				while (nextStart < mText.size() && mText[nextStart] == ' ') {
+					++nextStart;
+				}
+
+				return nextStart;
+			}
+
+			x += width;
+		}
+
+		mLines.push_back(Line { pos, i - pos, x });
+
+		return i;
+	}
+
+	/**
+	 * @brief Start of the line following the given one.
+	 */
+	inline size_t next (size_t index) const
+	{
+		if (index + 1 < mLines.size()) {
+			return mLines[index + 1].start;
+		}
+
+		return mText.size() + 1;
+	}
+
+	inline size_t wordStart (size_t pos) const
+	{
+		while (pos > 0 && mText[pos - 1] != ' ' && mText[pos - 1] != '\n') {
+			--pos;
+		}
+
+		return pos;
+	}
+
+	inline size_t firstWordEnd (size_t pos) const
+	{
+		while (pos < mText.size() && mText[pos] != ' ' && mText[pos] != '\n') {
+			++pos;
+		}
+
+		return pos;
+	}
+
+	const Font *mFont;
+	TSize mWidth;
+	TSize mLineSpacing = 0;
+	size_t mMaxLines = 0;
+	std::string mText;
+	std::vector<Line> mLines;
+};
+
+template<typename TSize>
+constexpr const char *TextLayout<TSize>::ELLIPSIS;
+
+} /* namespace maligui */
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "Device.hpp"
+#include "MemoryDevice.hpp"
+#include "PixelTraits.hpp"
+#include "Rectangle.hpp"
+
+namespace maligui
+{
+
+/**
+ * @brief Animation used when the screens are switched. Directions tell where
+ * the moving screen goes to.
+ */
+enum class TransitionType {
+	NONE,          /**< New screen is shown at once. */
+	SLIDE_LEFT,    /**< New screen pushes the old one out. */
+	SLIDE_RIGHT,
+	SLIDE_UP,
+	SLIDE_DOWN,
+	COVER_LEFT,    /**< New screen moves in over the old one. */
+	COVER_RIGHT,
+	COVER_UP,
+	COVER_DOWN,
+	UNCOVER_LEFT,  /**< Old screen moves out, uncovering the new one. */
+	UNCOVER_RIGHT,
+	UNCOVER_UP,
+	UNCOVER_DOWN,
+	FADE           /**< New screen fades in over the old one. */
+};
+
+/**
+ * @brief Returns the transition animating the change back, e.g. for popping
+ * the screen pushed with the given transition.
+ */
+inline TransitionType reversed (TransitionType type)
+{
+	switch (type) {
+	case TransitionType::SLIDE_LEFT:    return TransitionType::SLIDE_RIGHT;
+	case TransitionType::SLIDE_RIGHT:   return TransitionType::SLIDE_LEFT;
+	case TransitionType::SLIDE_UP:      return TransitionType::SLIDE_DOWN;
+	case TransitionType::SLIDE_DOWN:    return TransitionType::SLIDE_UP;
+	case TransitionType::COVER_LEFT:    return TransitionType::UNCOVER_RIGHT;
+	case TransitionType::COVER_RIGHT:   return TransitionType::UNCOVER_LEFT;
+	case TransitionType::COVER_UP:      return TransitionType::UNCOVER_DOWN;
+	case TransitionType::COVER_DOWN:    return TransitionType::UNCOVER_UP;
+	case TransitionType::UNCOVER_LEFT:  return TransitionType::COVER_RIGHT;
+	case TransitionType::UNCOVER_RIGHT: return TransitionType::COVER_LEFT;
+	case TransitionType::UNCOVER_UP:    return TransitionType::COVER_DOWN;
+	case TransitionType::UNCOVER_DOWN:  return TransitionType::COVER_UP;
+	default:                            return type;
+	}
+}
+
+template<typename TPixel, typename TSize = int>
+/**
+ * @brief The Transition class animates the change of an area of the screen,
+ * from one offscreen image of it to the other. Each frame is composed of the
+ * rows of the two images, copied to the device with Device::writeRow(), or,
+ * for the fades, blended a row at a time.
+ *
+ * The animation follows the time, not the frame count: each frame shows the
+ * state the animation should be in at the time it is painted. Frames that
+ * could not be painted in time are thus skipped, rather than slowing the
+ * animation down.
+ */
+class Transition
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	Transition(TransitionType                               type,
+	           typename Clock::duration                     duration,
+	           std::shared_ptr<MemoryDevice<TPixel, TSize>> from,
+	           std::shared_ptr<MemoryDevice<TPixel, TSize>> to,
+	           const Rectangle<TSize>                      &area) :
+		mType(type),
+		mDuration(duration),
+		mFrom(from),
+		mTo(to),
+		mArea(area)
+	{
+	}
+
+	/**
+	 * @brief Paints the frame due at the given time. The animation starts
+	 * with the first frame.
+	 * @return true once the last frame, showing only the new image, was
+	 * painted.
+	 */
+	bool frame (Device<TPixel, TSize> &device, typename Clock::time_point now)
+	{
+		if (!mStarted) {
+			mStart   = now;
+			mStarted = true;
+		}
+
+		// Progress, in 1/256 steps.
+		int progress = 256;
+
+		if (now - mStart < mDuration) {
+			progress = int((now - mStart) * 256 / mDuration);
+		}
+
+		compose(device, progress);
+
+		return progress == 256;
+	}
+
+	/**
+	 * @brief Paints the last frame at once, e.g. as the screens are switched
+	 * again before the transition ended.
+	 */
+	void finish (Device<TPixel, TSize> &device)
+	{
+		compose(device, 256);
+	}
+
+	inline const Rectangle<TSize> &area () const
+	{
+		return mArea;
+	}
+
+private:
+	/**
+	 * @brief Rows (or columns) [0, split) are taken from the first image,
+	 * and the rest from the second one, each shifted by the given offset.
+	 */
+	struct Split {
+		const MemoryDevice<TPixel, TSize> *first;
+		TSize firstOffset;
+		TSize split;
+		const MemoryDevice<TPixel, TSize> *second;
+		TSize secondOffset;
+	};
+
+	void compose (Device<TPixel, TSize> &device, int progress)
+	{
+		const MemoryDevice<TPixel, TSize> *from = mFrom.get();
+		const MemoryDevice<TPixel, TSize> *to   = mTo.get();
+		TSize w = mArea.width;
+		TSize h = mArea.height;
+		TSize x = TSize(w * progress / 256);
+		TSize y = TSize(h * progress / 256);
+
+		switch (mType) {
+		case TransitionType::SLIDE_LEFT:
+			return columns(device, Split { from, x, w - x, to, x - w });
+		case TransitionType::SLIDE_RIGHT:
+			return columns(device, Split { to, w - x, x, from, -x });
+		case TransitionType::SLIDE_UP:
+			return rows(device, Split { from, y, h - y, to, y - h });
+		case TransitionType::SLIDE_DOWN:
+			return rows(device, Split { to, h - y, y, from, -y });
+		case TransitionType::COVER_LEFT:
+			return columns(device, Split { from, 0, w - x, to, x - w });
+		case TransitionType::COVER_RIGHT:
+			return columns(device, Split { to, w - x, x, from, 0 });
+		case TransitionType::COVER_UP:
+			return rows(device, Split { from, 0, h - y, to, y - h });
+		case TransitionType::COVER_DOWN:
+			return rows(device, Split { to, h - y, y, from, 0 });
+		case TransitionType::UNCOVER_LEFT:
+			return columns(device, Split { from, x, w - x, to, 0 });
+		case TransitionType::UNCOVER_RIGHT:
+			return columns(device, Split { to, 0, x, from, -x });
+		case TransitionType::UNCOVER_UP:
+			return rows(device, Split { from, y, h - y, to, 0 });
+		case TransitionType::UNCOVER_DOWN:
+			return rows(device, Split { to, 0, y, from, -y });
+		case TransitionType::FADE:
+			return fade(device, progress);
+		default:
+			return rows(device, Split { to, 0, h, to, 0 });
+		}
+	}
+
+	void columns (Device<TPixel, TSize> &device, const Split &split)
+	{
+		TSize w = mArea.width;
+
+		for (TSize j = 0; j < mArea.height; ++j) {
+			if (split.split > 0) {
+				device.writeRow(mArea.x, mArea.y + j, split.split,
+				                split.first->data() + j * w + split.firstOffset);
+			}
+			if (split.split < w) {
+				device.writeRow(mArea.x + split.split, mArea.y + j, w - split.split,
+				                split.second->data() + j * w + split.split + split.secondOffset);
+			}
+		}
+	}
+
+	void rows (Device<TPixel, TSize> &device, const Split &split)
+	{
+		TSize w = mArea.width;
+
+		for (TSize j = 0; j < mArea.height; ++j) {
+			const TPixel *row = j < split.split
+			                    ? split.first->data() + (j + split.firstOffset) * w
+			                    : split.second->data() + (j + split.secondOffset) * w;
+
+			device.writeRow(mArea.x, mArea.y + j, w, row);
+		}
+	}
+
+	void fade (Device<TPixel, TSize> &device, int progress)
+	{
+		TSize w = mArea.width;
+		uint8_t intensity = uint8_t(progress * 255 / 256);
+
+		if (progress == 256) {
+			return rows(device, Split { mTo.get(), 0, mArea.height, mTo.get(), 0 });
+		}
+
+		mLine.resize(w);
+
+		for (TSize j = 0; j < mArea.height; ++j) {
+			PixelTraits<TPixel>::blend(mFrom->data() + j * w, mTo->data() + j * w,
+			                           mLine.data(), w, intensity);
+			device.writeRow(mArea.x, mArea.y + j, w, mLine.data());
+		}
+	}
+
+	TransitionType mType;
+	typename Clock::duration mDuration;
+	std::shared_ptr<MemoryDevice<TPixel, TSize>> mFrom;
+	std::shared_ptr<MemoryDevice<TPixel, TSize>> mTo;
+	Rectangle<TSize> mArea;
+	typename Clock::time_point mStart;
+	bool mStarted = false;
+	std::vector<TPixel> mLine;
+};
+
+} /* namespace maligui */
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <vector>
-#include <functional>
 
+#include "Arena.hpp"
+#include "Delegate.hpp"
+#include "Gesture.hpp"
+#include "GridIndex.hpp"
+#include "MemoryDevice.hpp"
 #include "Painter.hpp"
 #include "Rectangle.hpp"
 
@@ -19,7 +24,20 @@ template<typename TPixel, typename TSize = int>
  */
 class Widget
 {
-typedef std::function<bool (Widget<TPixel, TSize> *, Point<TSize> )> EventHandler;
+public:
+	/**
+	 * @brief Click handler. Takes the clicked widget and the click position,
+	 * and returns false to stop the click from propagating further.
+	 */
+	typedef Delegate<bool (Widget<TPixel, TSize> *, Point<TSize> )> EventHandler;
+
+	/**
+	 * @brief Gesture handler. Takes the widget the gesture started on and the
+	 * gesture, and returns false to stop it from propagating further.
+	 */
+	typedef Delegate<bool (Widget<TPixel, TSize> *, const Gesture<TSize> &)> GestureHandler;
+
+	typedef std::chrono::steady_clock Clock;
 
 public:
 	/**
@@ -28,9 +46,23 @@ public:
 	Widget(Rectangle<TSize> geometry =
 		{
 			0, 0, 0, 0
-		}) : mGeometry { geometry }
+		}) : Widget(nullptr, geometry)
+	{ }
+
+	/**
+	 * @brief Creates the widget allocating its children, and its own data
+	 * such as style overrides, from the arena. Arena::make() passes the arena
+	 * it creates the widget in.
+	 */
+	explicit Widget(Arena *arena, Rectangle<TSize> geometry =
+		{
+			0, 0, 0, 0
+		}) : mGeometry { geometry },
+		mChildren(ChildAllocator(arena))
 	{ }
 
+	virtual ~Widget() = default;
+
 	/**
 	 * @brief Propagates click to child widgets. Event will be propagated only
 	 * to the children which contain the coordinates of the click event.
@@ -45,12 +77,10 @@ public:
 	bool propagateClick (const Point<TSize> &p)
 	{
 		bool handle = true;
+		Widget<TPixel, TSize> *child = hitChild(p);
 
-		for (const auto &child : mChildren) {
-			if (child->geometry().contains(p)) {
-				handle = child->propagateClick(p);
-				break;
-			}
+		if (child) {
+			handle = child->propagateClick(p);
 		}
 		if (handle) {
 			handle = onClick(p);
@@ -59,6 +89,27 @@ public:
 		return handle;
 	}
 
+	/**
+	 * @brief Propagates the gesture to the child widgets, the same way as
+	 * propagateClick() does, to the children containing the point the touch
+	 * started at. The gesture is therefore delivered to the same widgets for
+	 * the whole duration of the touch, even once it leaves them.
+	 */
+	bool propagateGesture (const Gesture<TSize> &gesture)
+	{
+		bool handle = true;
+		Widget<TPixel, TSize> *child = hitChild(gesture.start);
+
+		if (child) {
+			handle = child->propagateGesture(gesture);
+		}
+		if (handle) {
+			handle = onGesture(gesture);
+		}
+
+		return handle;
+	}
+
 	/**
 	 * @brief Adds a new child to the widget. Widget will own the child, so
 	 * rvalue reference is required.
@@ -66,7 +117,16 @@ public:
 	 */
 	void addChild (std::unique_ptr<Widget<TPixel>> &&child)
 	{
+		child->mParent = this;
+
+		// Carry the pending repaint over to the new hierarchy.
+		if (child->dirty()) {
+			child->mDamage = Rectangle<TSize> { 0, 0, 0, 0 };
+			child->update();
+		}
+
 		mChildren.push_back(std::move(child));
+		mHitIndexStale = true;
 	}
 
 	/**
@@ -89,14 +149,106 @@ public:
 		return mChildren.size();
 	}
 
-	Rectangle<TSize> geometry ()
+	Rectangle<TSize> geometry () const
 	{
 		return mGeometry;
 	}
 
+	/**
+	 * @brief Moves or resizes the widget. The area it leaves is repainted by
+	 * the parent, and the widget is repainted at its new place.
+	 */
 	void geometry (Rectangle<TSize> g)
+	{
+		Rectangle<TSize> old = mGeometry;
+
+		if (g == old) {
+			return;
+		}
+
+		place(g);
+
+		if (mParent) {
+			mParent->invalidate(old);
+			invalidate(mGeometry);
+		} else {
+			invalidate(mGeometry.united(old));
+		}
+	}
+
+	/**
+	 * @brief Sets the geometry without scheduling any repaint, for the
+	 * containers which repaint their moved children themselves, such as the
+	 * ListView moving the pixels of its rows as it scrolls.
+	 */
+	void place (Rectangle<TSize> g)
 	{
 		mGeometry = g;
+		dropCache();
+
+		if (mParent) {
+			mParent->mHitIndexStale = true;
+		}
+	}
+
+	/**
+	 * @brief Enables the spatial index of the children, used to find the
+	 * clicked child without testing each of them. Worth enabling on the
+	 * containers with many children, such as keyboards and lists. The index
+	 * is rebuilt on the first click after the children were added or moved.
+	 */
+	void hitIndex (bool enable)
+	{
+		if (!enable) {
+			mHitIndex.reset();
+		} else if (!mHitIndex) {
+			mHitIndex      = std::make_unique<GridIndex<TSize>>();
+			mHitIndexStale = true;
+		}
+	}
+
+	/**
+	 * @brief Finds the child receiving the click at the given point, which is
+	 * the first child containing the point.
+	 * @return Raw (non-owning) pointer to the child, or nullptr if there is
+	 * none.
+	 */
+	Widget<TPixel, TSize> *hitChild (const Point<TSize> &p)
+	{
+		if (!mHitIndex) {
+			for (const auto &child : mChildren) {
+				if (child->geometry().contains(p)) {
+					return child.get();
+				}
+			}
+			return nullptr;
+		}
+
+		if (mHitIndexStale) {
+			std::vector<Rectangle<TSize>> rects;
+
+			rects.reserve(mChildren.size());
+			for (const auto &child : mChildren) {
+				rects.push_back(child->mGeometry);
+			}
+
+			mHitIndex->build(rects);
+			mHitIndexStale = false;
+		}
+
+		// Candidates come in the order of children, so the first match is
+		// the same child the linear search finds.
+		auto range = mHitIndex->candidates(p);
+
+		for (auto it = range.first; it != range.second; ++it) {
+			Widget<TPixel, TSize> *child = mChildren[*it].get();
+
+			if (child->geometry().contains(p)) {
+				return child;
+			}
+		}
+
+		return nullptr;
 	}
 
 	virtual bool onClick (const Point<TSize> &p)
@@ -112,22 +264,239 @@ public:
 		mClickHandler = handler;
 	}
 
-	virtual void initPainter (std::shared_ptr<Device<TPixel, TSize>> device)
+	/**
+	 * @brief Handles the gesture (press, drag, swipe...). Taps are also
+	 * delivered as clicks, to onClick().
+	 * @return false to stop the gesture from propagating to the parent.
+	 */
+	virtual bool onGesture (const Gesture<TSize> &gesture)
 	{
-		// Each widget has it's own painter, so it can change the painter
-		// properties without affecting other widgets.
-		mPainter = std::make_unique<Painter<TPixel>>(device, geometry());
-		// Let child widgets create their own painter objects.
-		for (auto &child : mChildren) {
-			child->initPainter(device);
+		if (mGestureHandler) {
+			return mGestureHandler(this, gesture);
+		}
+		return true;
+	}
+
+	virtual void onGestureHandler (GestureHandler handler)
+	{
+		mGestureHandler = handler;
+	}
+
+	/**
+	 * @brief Paints the children, clipped to the area currently painted.
+	 * Widgets overriding this method should paint themselves first, and then
+	 * call it to paint their children on top.
+	 * @param painter Painter of the surface, set up with the widget geometry
+	 *                and clip. Changes to its properties only last until the
+	 *                widget is painted.
+	 */
+	virtual void onPaint (Painter<TPixel, TSize> &painter)
+	{
+		Rectangle<TSize> clip = painter.clip();
+
+		for (size_t i = 0; i < mChildren.size(); ++i) {
+			mChildren[i]->paint(painter, uncovered(i, clip));
+		}
+	}
+
+	/**
+	 * @brief Paints the widget and all its children, clipped to the given
+	 * area and to the widget geometry.
+	 * @param painter Painter of the surface.
+	 * @param area    Area to paint, in device coordinates.
+	 */
+	void paint (Painter<TPixel, TSize> &painter, const Rectangle<TSize> &area)
+	{
+		Rectangle<TSize> clip = area.intersected(mGeometry);
+
+		if (clip.isEmpty()) {
+			// Nothing to paint, e.g. as the widget is covered.
+			clean();
+			return;
+		}
+
+		mDirty      = false;
+		mChildDirty = false;
+		mExposed    = false;
+
+		if (mCache) {
+			paintCached(painter, clip);
+			return;
+		}
+
+		auto state = painter.save();
+
+		painter.geometry(mGeometry);
+		painter.clip(clip);
+		onPaint(painter);
+		painter.restore(state);
+	}
+
+	/**
+	 * @brief Marks the widget as opaque, i.e. painting every pixel of its
+	 * geometry. Widgets and parts of widgets covered by the opaque siblings on
+	 * top of them are not painted.
+	 */
+	inline void opaque (bool opaque)
+	{
+		mOpaque = opaque;
+	}
+
+	inline bool opaque () const
+	{
+		return mOpaque;
+	}
+
+	/**
+	 * @brief Enables rendering of the widget, together with its children, to
+	 * an offscreen surface, which is then copied to the screen. The surface is
+	 * only rendered again once the widget, or any of its children, is
+	 * invalidated. Painting complex widgets that rarely change (e.g. dials,
+	 * chart axes or background panels) then costs a single copy. Cached
+	 * widgets are opaque, as the surface is copied over what lies behind.
+	 */
+	void cached (bool enable)
+	{
+		if (!enable) {
+			mCache.reset();
+		} else if (!mCache) {
+			mCache  = std::make_unique<Cache>(mGeometry);
+			mOpaque = true;
 		}
 	}
 
-	virtual void onPaint ()
+	inline bool cached () const
+	{
+		return mCache != nullptr;
+	}
+
+	/**
+	 * @brief Schedules the whole widget for repainting. Widgets keeping their
+	 * own pixels between the frames (e.g. ListView) override it to render
+	 * them all again.
+	 */
+	virtual void update ()
+	{
+		invalidate(mGeometry);
+	}
+
+	/**
+	 * @brief Schedules the widget and all its descendants for repainting,
+	 * e.g. after the theme was switched. Unlike update(), this also renders
+	 * the cached children again.
+	 */
+	void updateAll ()
 	{
 		for (auto &child : mChildren) {
-			child->onPaint();
+			child->updateAll();
 		}
+
+		update();
+	}
+
+	/**
+	 * @brief Schedules the given area of the widget for repainting. The
+	 * widget is marked dirty, and the area is added to the damage of the top
+	 * level widget, which is repainted on the next paintDamaged() call. A
+	 * widget which is not opaque does not cover its old pixels, so the area
+	 * is repainted from its nearest opaque ancestor instead.
+	 * @param rect Area to repaint, in device coordinates.
+	 */
+	void invalidate (const Rectangle<TSize> &rect)
+	{
+		Widget<TPixel, TSize> *root = this;
+
+		while (!root->mOpaque && root->mParent) {
+			root = root->mParent;
+		}
+
+		root->mDirty = true;
+		root = this;
+		mDirty = true;
+		dropCache();
+
+		while (root->mParent) {
+			root = root->mParent;
+			root->mChildDirty = true;
+			root->dropCache();
+		}
+
+		root->mDamage = root->mDamage.united(rect);
+	}
+
+	/**
+	 * @brief Schedules the area for repainting, as its pixels were painted
+	 * over, e.g. by the layers behind. Unlike invalidate(), widgets keeping
+	 * their own pixels between the frames (e.g. ListView) paint the area
+	 * again as a whole.
+	 * @param rect Area to repaint, in device coordinates.
+	 */
+	void expose (const Rectangle<TSize> &rect)
+	{
+		mExposed = true;
+		invalidate(rect);
+	}
+
+	/**
+	 * @brief Checks whether the widget, or any of its children, needs to be
+	 * repainted.
+	 */
+	inline bool dirty () const
+	{
+		return mDirty || mChildDirty;
+	}
+
+	/**
+	 * @brief Repaints the dirty widgets of the hierarchy, clipped to the
+	 * damaged area. Widgets that did not change are not painted, unless they
+	 * overlap a repainted sibling. Meant to be called on the top level widget.
+	 * @param painter  Painter of the surface.
+	 * @param deadline Once passed, the remaining dirty widgets are left for
+	 *                 the next call. At least one widget is always painted,
+	 *                 so that the painting makes progress.
+	 * @return true if all the damage was repainted.
+	 */
+	bool paintDamaged (Painter<TPixel, TSize> &painter,
+	                   Clock::time_point       deadline = Clock::time_point::max())
+	{
+		Rectangle<TSize> damage = mDamage;
+		bool painted = false;
+
+		mDamage = Rectangle<TSize> { 0, 0, 0, 0 };
+
+		if (!damage.isEmpty()) {
+			repaint(painter, damage, deadline, painted);
+		}
+
+		return mDamage.isEmpty();
+	}
+
+	/**
+	 * @brief Checks whether the hierarchy has areas waiting to be repainted.
+	 * Meant to be called on the top level widget.
+	 */
+	inline bool damaged () const
+	{
+		return !mDamage.isEmpty();
+	}
+
+	/**
+	 * @brief Returns the bounding rectangle of the areas waiting to be
+	 * repainted. Meant to be called on the top level widget.
+	 */
+	inline const Rectangle<TSize> &damage () const
+	{
+		return mDamage;
+	}
+
+	/**
+	 * @brief Drops the areas waiting to be repainted, e.g. as the hierarchy
+	 * is hidden. It has to be updated once shown again.
+	 */
+	void discardDamage ()
+	{
+		mDamage = Rectangle<TSize> { 0, 0, 0, 0 };
+		clean();
 	}
 
 	virtual unsigned int id ()
@@ -140,18 +509,207 @@ public:
 		mId = id;
 	}
 
-	virtual Painter<TPixel> *getPainter ()
+protected:
+	typedef ArenaAllocator<std::unique_ptr<Widget>> ChildAllocator;
+
+	/**
+	 * @brief Returns the arena the widget was created with, or nullptr.
+	 * Widgets allocate their own data (e.g. style overrides) from it as well.
+	 */
+	inline Arena *arena () const
 	{
-		return mPainter.get();
+		return mChildren.get_allocator().arena();
+	}
+
+	/**
+	 * @brief Repaints the dirty subtrees intersecting the damage.
+	 * @param painter  Painter of the surface.
+	 * @param damage   Area to repaint.
+	 * @param deadline Time after which the dirty subtrees are postponed.
+	 * @param painted  Set once any widget was painted.
+	 */
+	void repaint (Painter<TPixel, TSize> &painter,
+	              const Rectangle<TSize> &damage,
+	              Clock::time_point       deadline,
+	              bool                   &painted)
+	{
+		if (mDirty) {
+			mOwnPixels = !mExposed;
+			paint(painter, damage);
+			mOwnPixels = false;
+			painted = true;
+			return;
+		}
+
+		if (!mChildDirty) {
+			return;
+		}
+
+		if (mCache) {
+			// Surface is rendered as a whole.
+			paint(painter, damage);
+			painted = true;
+			return;
+		}
+
+		mChildDirty = false;
+
+		// Area repainted so far. Later siblings lie on top of the earlier
+		// ones, so the ones overlapping it need to be painted again.
+		Rectangle<TSize> repainted { 0, 0, 0, 0 };
+
+		for (size_t i = 0; i < mChildren.size(); ++i) {
+			auto &child = mChildren[i];
+			Rectangle<TSize> area = uncovered(i, damage);
+
+			if (area.isEmpty()) {
+				child->clean();
+			} else if (child->dirty() && painted && Clock::now() >= deadline) {
+				child->postpone(area);
+			} else if (child->dirty()) {
+				child->repaint(painter, area, deadline, painted);
+				repainted = repainted.united(area);
+			} else if (area.intersects(repainted)) {
+				child->paint(painter, area.intersected(repainted));
+			}
+		}
+	}
+
+	/**
+	 * @brief Returns the part of the area, within the child geometry, which is
+	 * not covered by the opaque siblings on top of the child. Only the areas
+	 * covered by a single sibling are left out.
+	 */
+	Rectangle<TSize> uncovered (size_t index, const Rectangle<TSize> &area) const
+	{
+		Rectangle<TSize> visible = area.intersected(mChildren[index]->mGeometry);
+
+		for (size_t i = index + 1; i < mChildren.size() && !visible.isEmpty(); ++i) {
+			const Widget<TPixel, TSize> &sibling = *mChildren[i];
+
+			if (sibling.mOpaque) {
+				visible = visible.subtracted(sibling.mGeometry);
+			}
+		}
+
+		return visible;
+	}
+
+	/**
+	 * @brief Clears the dirty flags of the widget and its children, without
+	 * painting them.
+	 */
+	void clean ()
+	{
+		if (mChildDirty) {
+			for (auto &child : mChildren) {
+				child->clean();
+			}
+		}
+
+		mDirty      = false;
+		mChildDirty = false;
+		mExposed    = false;
+	}
+
+	/**
+	 * @brief Checks whether the widget is painted over its own pixels of the
+	 * last frame, as it is repainted on its own, rather than as a part of its
+	 * parent, which has just painted over them. Widgets keeping their own
+	 * pixels between the frames (e.g. ListView) then only paint what changed.
+	 */
+	inline bool ownPixels () const
+	{
+		return mOwnPixels;
+	}
+
+	/**
+	 * @brief Offscreen surface of the cached widget.
+	 */
+	struct Cache
+	{
+		Cache(const Rectangle<TSize> &geometry) :
+			surface(std::make_shared<MemoryDevice<TPixel, TSize>>(geometry)),
+			painter(surface)
+		{
+		}
+
+		std::shared_ptr<MemoryDevice<TPixel, TSize>> surface;
+		Painter<TPixel, TSize> painter;
+		bool valid = false;
+	};
+
+	/**
+	 * @brief Renders the widget to its surface, unless it is still valid,
+	 * and copies the clipped part of it to the painter.
+	 */
+	void paintCached (Painter<TPixel, TSize> &painter, const Rectangle<TSize> &clip)
+	{
+		if (!mCache->valid) {
+			if (mCache->surface->width() != mGeometry.width ||
+			    mCache->surface->height() != mGeometry.height) {
+				mCache = std::make_unique<Cache>(mGeometry);
+			}
+
+			Painter<TPixel, TSize> &offscreen = mCache->painter;
+			auto state = offscreen.save();
+
+			mCache->surface->origin(Point<TSize> { mGeometry.x, mGeometry.y });
+			offscreen.geometry(mGeometry);
+			offscreen.clip(mGeometry);
+			onPaint(offscreen);
+			offscreen.restore(state);
+
+			mCache->valid = true;
+		}
+
+		auto state = painter.save();
+
+		painter.clip(clip);
+		painter.image(mGeometry, mCache->surface->data());
+		painter.restore(state);
+	}
+
+	inline void dropCache ()
+	{
+		if (mCache) {
+			mCache->valid = false;
+		}
+	}
+
+	/**
+	 * @brief Leaves the dirty widget for the next paintDamaged() call, by
+	 * adding the area back to the damage. Unlike invalidate(), this does not
+	 * mark the whole widget dirty.
+	 */
+	void postpone (const Rectangle<TSize> &area)
+	{
+		Widget<TPixel, TSize> *root = this;
+
+		while (root->mParent) {
+			root = root->mParent;
+			root->mChildDirty = true;
+		}
+
+		root->mDamage = root->mDamage.united(area);
 	}
 
-protected:
 	//Painter<TPixel> &painter;
 	unsigned int mId;
 	EventHandler mClickHandler;
+	GestureHandler mGestureHandler;
 	Rectangle<TSize> mGeometry;
-	std::unique_ptr<Painter<TPixel>> mPainter;
-	std::vector<std::unique_ptr<Widget>> mChildren;
+	std::vector<std::unique_ptr<Widget>, ChildAllocator> mChildren;
+	Widget<TPixel, TSize> *mParent = nullptr;
+	bool mDirty      = false;
+	bool mChildDirty = false;
+	bool mOpaque     = false;
+	bool mExposed    = false;
+	bool mOwnPixels  = false;
+	Rectangle<TSize> mDamage { 0, 0, 0, 0 };
+	std::unique_ptr<GridIndex<TSize>> mHitIndex;
+	bool mHitIndexStale = false;
+	std::unique_ptr<Cache> mCache;
 
 };
 
@@ -1,13 +1,19 @@
 #include <QApplication>
+#include <QTimer>
 
-#include <functional>
+#include <stdexcept>
 
 #include "mali-gui/Stacker.hpp"
 #include "mali-gui/Button.hpp"
 #include "mali-gui/Layout.hpp"
 #include "mali-gui/FontDatabase.hpp"
+#include "mali-gui/TextDisplay.hpp"
 #include "qt-wrapper/device_emulator.hpp"
 
+// Font handles are computed at compile time, so the font lookup needs neither
+// strings nor a search through the font database.
+constexpr maligui::FontHandle NUMPAD_FONT("Consolas", 18);
+
 int applyOperation (int arg1, int arg2, char operation)
 {
 	switch (operation) {
@@ -28,8 +34,8 @@ int applyOperation (int arg1, int arg2, char operation)
 	}
 }
 
-bool handleNumpadBtnClick (maligui::Button<QColor> *displayPtr,
-                           maligui::Widget<QColor, int> *w,
+bool handleNumpadBtnClick (maligui::TextDisplay<QColor> *displayPtr,
+                           maligui::Button<QColor>      *button,
                            maligui::Point<int> p)
 {
 	(void) p;
@@ -41,11 +47,6 @@ bool handleNumpadBtnClick (maligui::Button<QColor> *displayPtr,
 		return false;
 	}
 
-	auto button = dynamic_cast<maligui::Button<QColor, int> *>(w);
-	if (button == nullptr) {
-		return false;
-	}
-
 	if (clearScreen) {
 		displayPtr->text("");
 		clearScreen = false;
@@ -85,34 +86,43 @@ int main (int argc, char *argv[])
 	// Emulate 240x320 device. Stacker is our interface to the Gui system.
 	maligui::Stacker<QColor> stacker(std::make_shared<DeviceEmulator>(240, 320));
 
+	// All widgets of the screen are allocated from a single arena, released
+	// at once when the screen is popped from the stacker.
+	auto arena = std::make_unique<maligui::Arena>(16 * 1024);
+
 	// Main window Widget, use all available screen space
-	auto window = std::make_unique<maligui::Widget<QColor>>();
+	auto window = arena->make<maligui::Widget<QColor>>();
 	window->geometry({ 0, 0, stacker.width(), stacker.height() });
 
-	// Create Calculator display. Make it a button, so we can make it to reset
-	// the result to zero when clicked.
-	auto display = std::make_unique<maligui::Button<QColor>>();
+	// Create Calculator display. Setting its text repaints only the digits
+	// which changed.
+	auto display = arena->make<maligui::TextDisplay<QColor>>();
 	display->geometry(maligui::Rectangle<int> { 10, 20, stacker.width() - 20, 40 });
 	display->backgroundColor(QColor(Qt::yellow));
 	display->foregroundColor(Qt::black);
+	display->borderColor(Qt::black);
 	display->horizontalAlign(maligui::align::Horizontal::RIGHT);
+	display->verticalAlign(maligui::align::Vertical::CENTER);
 	display->setFont("Century Schoolbook L", 24);
 	display->text("0");
 
 	// On click handler for numpad buttons. Make sure it is defined *before*
 	// the display is added to the main window, as otherwise the display smart
 	// pointer would be invalid. We know our display object will live throughout
-	// the application, so it's safe to do so.
-	auto numpadBtnClickHandler = std::bind(handleNumpadBtnClick,
-	                                       display.get(),
-	                                       std::placeholders::_1,
-	                                       std::placeholders::_2);
+	// the application, so it's safe to do so. Buttons pass themselves to the
+	// handler as a Button, so it needs no casts, and as it only captures a
+	// pointer, it is stored in each button without allocating.
+	auto displayPtr            = display.get();
+	auto numpadBtnClickHandler = [displayPtr](maligui::Button<QColor> *button,
+	                                          maligui::Point<int>      p) {
+		return handleNumpadBtnClick(displayPtr, button, p);
+	};
 
 	// Add the display to the main winow and let it take the ownership.
 	window->addChild(std::move(display));
 
 	// Create the numpad area.
-	auto numpad = std::make_unique<maligui::Widget<QColor>>();
+	auto numpad = arena->make<maligui::Widget<QColor>>();
 	numpad->geometry(maligui::Rectangle<int> { 10, 80, stacker.width() - 20, 230 });
 
 	// Create 12 labels for our numpad buttons.
@@ -123,17 +133,30 @@ int main (int argc, char *argv[])
 		"0", "C", "=", "/"
 	};
 
+	// All numpad buttons share a single style, instead of each button keeping
+	// its own copy of the colors and the font.
+	static const maligui::Style<QColor> numpadStyle {
+		QColor("#555555"),                      /* Background */
+		QColor("#CCCCCC"),                      /* Foreground */
+		QColor("#CCCCCC"),                      /* Border */
+		maligui::FontDatabase::get(NUMPAD_FONT),
+		maligui::align::Horizontal::CENTER,
+		maligui::align::Vertical::CENTER
+	};
+
 	// Now create a numpad button maligui::Widget for each label
 	for (auto &label : labels) {
-		auto button = std::make_unique<maligui::Button<QColor>>();
+		auto button = arena->make<maligui::Button<QColor>>();
 		button->text(label);
-		button->backgroundColor(QColor("#555555"));
-		button->foregroundColor(QColor("#CCCCCC"));
+		button->style(&numpadStyle);
 		button->onClickHandler(numpadBtnClickHandler);
-		button->setFont("Consolas", 18);
 		numpad->addChild(std::move(button));
 	}
 
+	// Find the clicked button via the spatial index rather than by testing
+	// each button in turn.
+	numpad->hitIndex(true);
+
 	// Align numpad buttons into the 4x4 grid, with 5px padding.
 	maligui::makeGrid<QColor>(numpad.get(), /* Parent maligui::Widget */
 	                          4,            /* Num horizontal */
@@ -145,8 +168,17 @@ int main (int argc, char *argv[])
 	window->addChild(std::move(numpad));
 
 	// Finaly, put the created mainwindow widget at the top of our display. It
-	// will now be the active widget, receiving click events.
-	stacker.push(window.get());
+	// will now be the active widget, receiving click events. Stacker takes the
+	// ownership of the window, and of the arena it lives in.
+	stacker.push(std::move(window), std::move(arena));
+
+	// Widgets only invalidate themselves when changed. Paint all the changes
+	// in a single pass per frame, at about 60 frames per second.
+	QTimer frameTimer;
+	QObject::connect(&frameTimer, &QTimer::timeout, [&stacker]() {
+		stacker.tick();
+	});
+	frameTimer.start(16);
 
 	return a.exec();
 }
@@ -34,14 +34,57 @@ HEADERS  += \
     qt-wrapper/device_emulator.hpp \
     mali-gui/fonts/autogen.h \
     mali-gui/Button.hpp \
+    mali-gui/Label.hpp \
     mali-gui/Device.hpp \
+    mali-gui/EventQueue.hpp \
+    mali-gui/InputEvent.hpp \
     mali-gui/Layout.hpp \
+    mali-gui/ListView.hpp \
+    mali-gui/Overlay.hpp \
     mali-gui/Painter.hpp \
+    mali-gui/PixelTraits.hpp \
     mali-gui/Point.hpp \
     mali-gui/Rectangle.hpp \
+    mali-gui/Snapshot.hpp \
     mali-gui/Stacker.hpp \
+    mali-gui/StaticButton.hpp \
+    mali-gui/StaticScreen.hpp \
+    mali-gui/StripChart.hpp \
+    mali-gui/Style.hpp \
+    mali-gui/TextDisplay.hpp \
+    mali-gui/Transition.hpp \
     mali-gui/MemoryDevice.hpp \
     mali-gui/Widget.hpp \
+    mali-gui/GridIndex.hpp \
     mali-gui/Alignment.hpp \
+    mali-gui/Arena.hpp \
+    mali-gui/Delegate.hpp \
+    mali-gui/Gesture.hpp \
     mali-gui/Font.hpp \
-    mali-gui/FontDatabase.hpp
+    mali-gui/FontDatabase.hpp \
+    mali-gui/MappedFont.hpp \
+    mali-gui/SdfFont.hpp \
+    mali-gui/TextLayout.hpp
+
+# Optional font subsetting, enabled with "qmake CONFIG+=font_subset". Instead
+# of the stock font set, only the glyphs used by the calculator are compiled
+# in. See tools/subset_fonts.py for details.
+font_subset {
+    FONT_SUBSET_TOOL = $$PWD/../tools/subset_fonts.py
+    FONT_SUBSET_INPUTS = $$PWD/../mali-gui/fonts/autogen.h \
+                         $$PWD/main.cpp \
+                         $$PWD/glyphs.manifest
+
+    fontsubset.target = fonts_subset.h
+    fontsubset.depends = $$FONT_SUBSET_TOOL $$FONT_SUBSET_INPUTS
+    fontsubset.commands = python3 $$FONT_SUBSET_TOOL \
+                          --source $$PWD/main.cpp \
+                          --manifest $$PWD/glyphs.manifest \
+                          -o fonts_subset.h \
+                          $$PWD/../mali-gui/fonts/autogen.h
+
+    QMAKE_EXTRA_TARGETS += fontsubset
+    PRE_TARGETDEPS += fonts_subset.h
+    INCLUDEPATH += $$OUT_PWD
+    DEFINES += MALIGUI_FONTS_HEADER=\\\"fonts_subset.h\\\"
+}
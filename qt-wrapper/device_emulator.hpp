@@ -7,17 +7,56 @@
 #include <QPixmap>
 #include <utility>
 #include <QDebug>
+#include <QKeyEvent>
 #include <QMouseEvent>
 #include <queue>
 #include "mali-gui/Device.hpp"
+#include "mali-gui/PixelTraits.hpp"
 #include "mali-gui/Point.hpp"
 
+namespace maligui
+{
+
+/**
+ * @brief Blending of QColor pixels, e.g. for the text painted to the offscreen
+ * surfaces, and their comparison for the compressed snapshots.
+ */
+template<>
+struct PixelTraits<QColor>
+{
+    static inline QColor blend(QColor background, QColor color, uint8_t intensity)
+    {
+        auto mix = [intensity](int b, int c) {
+            return (c * intensity + b * (255 - intensity) + 127) / 255;
+        };
+
+        return QColor(mix(background.red(), color.red()),
+                      mix(background.green(), color.green()),
+                      mix(background.blue(), color.blue()));
+    }
+
+    static inline void blend(const QColor *background, const QColor *color,
+                             QColor *out, size_t length, uint8_t intensity)
+    {
+        for (size_t i = 0; i < length; ++i) {
+            out[i] = blend(background[i], color[i], intensity);
+        }
+    }
+
+    static inline bool equal(const QColor &a, const QColor &b)
+    {
+        return a == b;
+    }
+};
+
+} /* namespace maligui */
+
 /**
  * @brief The DeviceEmulator class creates a generic software device that can
  * be used for easier development, as it allows application to run directly on
- * the host machine. It supports output via Gui window and input via mouse
- * clicking. It is implemented as a very thin wrapper arround the Qt's QWidget
- * class.
+ * the host machine. It supports output via Gui window, input via mouse
+ * clicking (and dragging), and keyboard. It is implemented as a very thin
+ * wrapper arround the Qt's QWidget class.
  */
 class DeviceEmulator : public maligui::Device<QColor>, public QWidget
 {
@@ -69,6 +108,21 @@ public:
         onPress({event->x(), event->y()});
     }
 
+    void mouseMoveEvent(QMouseEvent *event) override
+    {
+        onMove({event->x(), event->y()});
+    }
+
+    void mouseReleaseEvent(QMouseEvent *event) override
+    {
+        onRelease({event->x(), event->y()});
+    }
+
+    void keyPressEvent(QKeyEvent *event) override
+    {
+        onKey(event->key());
+    }
+
 private:
 
     std::queue<std::pair<QPoint, QColor>> renderQueue;
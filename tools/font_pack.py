@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Converts a mali-gui font file (see mali-gui/fonts/autogen.h, or the output of
+subset_fonts.py) into binary font files, which MappedFont maps and uses in
+place at runtime. One file, named "<name>-<size>.mgf", is written per font.
+
+File layout (little endian), matching mali-gui/MappedFont.hpp:
+
+  header   magic "MGFT", u16 version, u16 size, u16 height, u16 count,
+           u8 fallback, 3 reserved bytes, char name[32]
+  index    count x { u8 code, u8 reserved, u16 width, u32 offset },
+           sorted by code
+  coverage glyph pixmaps, width x height bytes each, back to back
+
+Example:
+
+  ./tools/font_pack.py mali-gui/fonts/autogen.h fonts/
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+from subset_fonts import parse_fonts
+
+VERSION = 1
+HEADER = struct.Struct('<4sHHHHB3x32s')
+GLYPH = struct.Struct('<BxHI')
+
+
+def pack(font, fallback):
+    name = font['name'].encode('utf-8')
+    if len(name) >= 32:
+        sys.exit('%s: font name too long' % font['name'])
+
+    codes = sorted(font['glyphs'])
+    index = []
+    blob = bytearray()
+    for code in codes:
+        width, pixmap = font['glyphs'][code]
+        if len(pixmap) != width * font['height']:
+            sys.exit('%s %d: glyph %d has unexpected size' %
+                     (font['name'], font['size'], code))
+        index.append(GLYPH.pack(code, width, len(blob)))
+        blob.extend(pixmap)
+
+    fallback = fallback if fallback in font['glyphs'] else 0
+    header = HEADER.pack(b'MGFT', VERSION, font['size'], font['height'],
+                         len(codes), fallback, name)
+    return header + b''.join(index) + bytes(blob)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('fonts', help='input font file (e.g. mali-gui/fonts/autogen.h)')
+    parser.add_argument('outdir', help='directory to write the binary fonts to')
+    parser.add_argument('--fallback', default='?',
+                        help='glyph drawn for characters missing in the font')
+    args = parser.parse_args()
+
+    fallback = ord(args.fallback[0]) if args.fallback else 0
+    os.makedirs(args.outdir, exist_ok=True)
+
+    for font in parse_fonts(open(args.fonts, encoding='utf-8').read()):
+        path = os.path.join(args.outdir, '%s-%d.mgf' % (font['name'], font['size']))
+        # Written aside and renamed over, as running applications may have
+        # the old file mapped.
+        with open(path + '.tmp', 'wb') as out:
+            out.write(pack(font, fallback))
+        os.replace(path + '.tmp', path)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Converts rendered mali-gui fonts (see mali-gui/fonts/autogen.h) into signed
+distance field typefaces, which SdfFont renders at any size. One typeface is
+emitted per font family, from its largest rendered size, as larger sources
+give more precise outlines. The atlas is downsampled by the given factor, so
+it takes a fraction of the flash of a single bitmap size.
+
+Strokes need to span about two atlas samples to survive, so the source has
+to be rendered at about 24 pixels of height per downsample step, e.g. 48
+pixels for the default downsample of 2. Each glyph is rendered back from its
+atlas and compared with the source, and the script refuses to run if any of
+them loses its shape.
+
+The output is a header defining the typefaces, to be registered with the
+FontDatabase by the application:
+
+  #include "sdf_fonts.h"
+  for (const auto &typeface : _SDF_FONTS_) {
+      maligui::FontDatabase::add(typeface);
+  }
+
+Example:
+
+  ./tools/sdf_fonts.py --downsample 2 fonts_48.h > sdf_fonts.h
+"""
+
+import argparse
+import math
+import sys
+
+from subset_fonts import parse_fonts
+
+
+# Coverage on the glyph outline.
+LEVEL = 127.5
+
+
+def outline(width, height, pixmap):
+    """Traces the outline of the glyph, as the segments where the coverage,
+    bilinearly interpolated between the pixel centers, crosses the half.
+    Antialiased pixels place the outline within the pixel, unlike a threshold.
+    Returns the coverage lookup (zero outside of the pixmap) and the segments.
+    """
+    def coverage(x, y):
+        if 0 <= x < width and 0 <= y < height:
+            return pixmap[y * width + x]
+        return 0
+
+    def crossing(x0, y0, x1, y1):
+        v0, v1 = coverage(x0, y0), coverage(x1, y1)
+        t = (LEVEL - v0) / (v1 - v0)
+        return (x0 + t * (x1 - x0), y0 + t * (y1 - y0))
+
+    segments = []
+    for y in range(-1, height):
+        for x in range(-1, width):
+            corners = [(x, y), (x + 1, y), (x + 1, y + 1), (x, y + 1)]
+            states = [coverage(*c) >= LEVEL for c in corners]
+            points = [crossing(*corners[k], *corners[(k + 1) % 4])
+                      for k in range(4) if states[k] != states[(k + 1) % 4]]
+            if len(points) == 2:
+                segments.append((points[0], points[1]))
+            elif len(points) == 4:
+                # Saddle: the center decides which corners are connected.
+                center = sum(coverage(*c) for c in corners) / 4 >= LEVEL
+                if center == states[0]:
+                    segments += [(points[0], points[1]), (points[2], points[3])]
+                else:
+                    segments += [(points[3], points[0]), (points[1], points[2])]
+
+    return coverage, segments
+
+
+def bilinear(sample, x, y):
+    x0, y0 = math.floor(x), math.floor(y)
+    fx, fy = x - x0, y - y0
+    top = sample(x0, y0) * (1 - fx) + sample(x0 + 1, y0) * fx
+    bottom = sample(x0, y0 + 1) * (1 - fx) + sample(x0 + 1, y0 + 1) * fx
+    return top * (1 - fy) + bottom * fy
+
+
+def segment_distance(px, py, segment):
+    (ax, ay), (bx, by) = segment
+    dx, dy = bx - ax, by - ay
+    length = dx * dx + dy * dy
+    t = 0.0 if length == 0 else max(0.0, min(1.0, ((px - ax) * dx + (py - ay) * dy) / length))
+    return math.hypot(ax + t * dx - px, ay + t * dy - py)
+
+
+def distance_field(width, height, pixmap, downsample, spread):
+    """Samples the signed distance to the glyph outline, in atlas samples.
+    Each atlas sample covers downsample source pixels in each direction, so
+    the atlas covers a source extent rounded up to whole samples."""
+    coverage, segments = outline(width, height, pixmap)
+
+    atlas_width = max(1, math.ceil(width / downsample))
+    atlas_height = math.ceil(height / downsample)
+    limit = spread * downsample
+    field = []
+
+    for ay in range(atlas_height):
+        for ax in range(atlas_width):
+            # Center of the atlas sample, in source pixels.
+            sx = (ax + 0.5) * downsample - 0.5
+            sy = (ay + 0.5) * downsample - 0.5
+            nearby = [s for s in segments
+                      if min(s[0][0], s[1][0]) - limit <= sx <= max(s[0][0], s[1][0]) + limit and
+                      min(s[0][1], s[1][1]) - limit <= sy <= max(s[0][1], s[1][1]) + limit]
+            nearest = min([limit] + [segment_distance(sx, sy, s) for s in nearby])
+            sign = 1 if bilinear(coverage, sx, sy) >= LEVEL else -1
+            value = 128 + sign * nearest / downsample * 127 / spread
+            field.append(max(0, min(255, int(round(value)))))
+
+    return atlas_width, field
+
+
+def mismatches(width, height, pixmap, atlas_width, field, downsample):
+    """Renders the field back at the source size, as SdfFont does, and counts
+    the pixels clearly inside (or outside) of the source glyph which end up on
+    the other side of the outline. Antialiased edge pixels are not counted."""
+    atlas_height = len(field) // atlas_width
+
+    def sample(x, y):
+        x = max(0, min(x, atlas_width - 1))
+        y = max(0, min(y, atlas_height - 1))
+        return field[y * atlas_width + x]
+
+    count = 0
+    for y in range(height):
+        for x in range(width):
+            ax = max(0.0, min((x + 0.5) / downsample - 0.5, atlas_width - 1))
+            ay = max(0.0, min((y + 0.5) / downsample - 0.5, atlas_height - 1))
+            inside = bilinear(sample, ax, ay) >= 128
+            value = pixmap[y * width + x]
+            if (value >= 192 and not inside) or (value <= 63 and inside):
+                count += 1
+
+    return count
+
+
+def emit(typefaces, out):
+    out.write('maligui::SdfTypeface _SDF_FONTS_[] = \n{\n')
+    for face in typefaces:
+        out.write('\t{\n')
+        out.write('\t\t"%s",\n' % face['name'].replace('"', '\\"'))
+        out.write('\t\t%d,\n' % face['size'])
+        out.write('\t\t%d,\n' % face['height'])
+        out.write('\t\t%d,\n' % face['atlas_height'])
+        out.write('\t\t%d,\n' % face['downsample'])
+        out.write('\t\t%d,\n' % face['spread'])
+        out.write('\t\t{\n')
+        for code, width, atlas_width, field in face['glyphs']:
+            out.write('\t\t\t{\n')
+            out.write('\t\t\t\t%d,\n' % code)
+            out.write('\t\t\t\t%d,\n' % width)
+            out.write('\t\t\t\t%d,\n' % atlas_width)
+            out.write('\t\t\t\t{\n')
+            for row in range(0, len(field), atlas_width):
+                out.write('\t\t\t\t\t%s,\n' %
+                          ','.join(str(v) for v in field[row:row + atlas_width]))
+            out.write('\t\t\t\t}\n')
+            out.write('\t\t\t},\n')
+        out.write('\t\t}\n')
+        out.write('\t},\n')
+    out.write('};\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('fonts', help='input font file (e.g. mali-gui/fonts/autogen.h)')
+    parser.add_argument('--downsample', type=int, default=2,
+                        help='source pixels per atlas sample (default: 2)')
+    parser.add_argument('--spread', type=int, default=2,
+                        help='encoded distance range, in atlas samples (default: 2)')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    if args.downsample < 1 or args.spread < 1:
+        sys.exit('downsample and spread must be positive')
+
+    largest = {}
+    for font in parse_fonts(open(args.fonts, encoding='utf-8').read()):
+        if font['name'] not in largest or font['size'] > largest[font['name']]['size']:
+            largest[font['name']] = font
+
+    typefaces = []
+    for font in largest.values():
+        glyphs = []
+        broken = []
+        for code in sorted(font['glyphs']):
+            width, pixmap = font['glyphs'][code]
+            atlas_width, field = distance_field(width, font['height'], pixmap,
+                                                args.downsample, args.spread)
+            if mismatches(width, font['height'], pixmap, atlas_width, field, args.downsample):
+                broken.append(chr(code))
+            glyphs.append((code, width, atlas_width, field))
+        if broken:
+            sys.exit('%s %d is too small for downsample %d, glyphs %r lose their shape; '
+                     'render the source larger, or lower the downsample' %
+                     (font['name'], font['size'], args.downsample, ''.join(broken)))
+        typefaces.append({
+            'name': font['name'],
+            'size': font['size'],
+            'height': font['height'],
+            'atlas_height': math.ceil(font['height'] / args.downsample),
+            'downsample': args.downsample,
+            'spread': args.spread,
+            'glyphs': glyphs,
+        })
+
+    out = open(args.output, 'w', encoding='utf-8') if args.output else sys.stdout
+    emit(typefaces, out)
+
+
+if __name__ == '__main__':
+    main()
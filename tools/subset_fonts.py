@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""
+Emits a subset of a mali-gui font file, containing only the glyphs the UI
+actually uses.
+
+The input is a font file in the format produced by FontRenderer (see
+mali-gui/fonts/autogen.h). The set of needed glyphs is collected from:
+
+ * string and character literals found in the given C++ sources. Glyphs are
+   added to every font the sources select via setFont("<name>", <size>) or
+   FontHandle("<name>", <size>), as the scanner can not tell which widget a
+   literal ends up in;
+ * an optional glyph manifest, for text that is built at runtime. Each line
+   has the form "<font name> <size>: <glyphs>", or "*: <glyphs>" to add the
+   glyphs to every selected font. Lines starting with '#' are ignored.
+
+Fonts that are not selected are dropped, except for the first font, which
+FontDatabase returns for unknown fonts. Glyphs requested from fonts missing in
+the input are added to that first font for the same reason.
+
+The output is written in the same format FontDatabase consumes, using the
+sparse (subset) Font constructor. The fallback glyph (--fallback, '?' by
+default) is always kept, and is drawn for characters missing in the subset.
+
+Example:
+
+  ./tools/subset_fonts.py --source qt-demo/main.cpp \\
+      --manifest qt-demo/glyphs.manifest \\
+      mali-gui/fonts/autogen.h > fonts_subset.h
+"""
+
+import argparse
+import ast
+import re
+import sys
+
+ESCAPES = {
+    'n': '\n', 't': '\t', 'r': '\r', '0': '\0',
+    '\\': '\\', '"': '"', "'": "'", '?': '?',
+}
+
+STRING_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"|\'((?:[^\'\\\n]|\\.)+)\'')
+SET_FONT_RE = re.compile(r'(?:setFont|FontHandle(?:\s+\w+)?)\s*\(\s*'
+                         r'"((?:[^"\\]|\\.)*)"\s*,\s*(\d+)\s*\)')
+COMMENT_RE = re.compile(r'//[^\n]*|/\*.*?\*/', re.S)
+DIRECTIVE_RE = re.compile(r'^\s*#.*$', re.M)
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        ch = literal[i]
+        if ch == '\\' and i + 1 < len(literal):
+            nxt = literal[i + 1]
+            if nxt == 'x':
+                digits = re.match(r'[0-9a-fA-F]+', literal[i + 2:])
+                if digits:
+                    out.append(chr(int(digits.group(0), 16) & 0xFF))
+                    i += 2 + len(digits.group(0))
+                    continue
+            out.append(ESCAPES.get(nxt, nxt))
+            i += 2
+        else:
+            out.append(ch)
+            i += 1
+    return ''.join(out)
+
+
+def parse_fonts(text):
+    """Parses the C initializer list of the font file into Python lists."""
+    start = text.index('{')
+    end = text.rindex('}')
+    body = text[start:end + 1]
+    body = COMMENT_RE.sub('', body)
+    body = body.replace('{', '[').replace('}', ']')
+    body = re.sub(r"'((?:[^'\\]|\\.)+)'",
+                  lambda m: str(ord(unescape(m.group(1)))), body)
+    fonts = []
+    # Only lists, numbers and strings, never evaluated as code.
+    for entry in ast.literal_eval(body):
+        name, size, height = entry[0], entry[1], entry[2]
+        if isinstance(entry[3], list):
+            codes, chars = entry[3], entry[4]
+        else:
+            codes = list(range(entry[3], entry[3] + len(entry[5])))
+            chars = entry[5]
+        fonts.append({
+            'name': name,
+            'size': size,
+            'height': height,
+            'glyphs': dict(zip(codes, chars)),
+        })
+    return fonts
+
+
+def scan_source(path, needed):
+    text = open(path, encoding='utf-8', errors='replace').read()
+    text = DIRECTIVE_RE.sub('', COMMENT_RE.sub('', text))
+    for match in SET_FONT_RE.finditer(text):
+        needed.setdefault((unescape(match.group(1)), int(match.group(2))), set())
+    # Font names are not displayed, so skip them when collecting glyphs.
+    text = SET_FONT_RE.sub('', text)
+    glyphs = set()
+    for match in STRING_RE.finditer(text):
+        literal = match.group(1) if match.group(1) is not None else match.group(2)
+        glyphs.update(unescape(literal))
+    return glyphs
+
+
+def read_manifest(path, needed, common):
+    for lineno, line in enumerate(open(path, encoding='utf-8'), 1):
+        line = line.rstrip('\n')
+        if not line.strip() or line.lstrip().startswith('#'):
+            continue
+        key, sep, glyphs = line.partition(':')
+        if not sep:
+            sys.exit('%s:%d: expected "<font> <size>: <glyphs>"' % (path, lineno))
+        glyphs = unescape(glyphs.strip())
+        key = key.strip()
+        if key == '*':
+            common.update(glyphs)
+            continue
+        name, _, size = key.rpartition(' ')
+        if not name or not size.isdigit():
+            sys.exit('%s:%d: expected "<font> <size>: <glyphs>"' % (path, lineno))
+        needed.setdefault((name.strip(), int(size)), set()).update(glyphs)
+
+
+def emit(fonts, fallback, out):
+    out.write('maligui::Font _FONTS_[] = \n{\n')
+    for font in fonts:
+        codes = sorted(font['glyphs'])
+        out.write('\t{\n')
+        out.write('\t\t"%s",\n' % font['name'].replace('"', '\\"'))
+        out.write('\t\t%d,\n' % font['size'])
+        out.write('\t\t%d,\n' % font['height'])
+        out.write('\t\t{ %s },\n' % ', '.join(str(c) for c in codes))
+        out.write('\t\t{\n')
+        for code in codes:
+            width, pixmap = font['glyphs'][code]
+            out.write('\t\t\t{\n')
+            out.write('\t\t\t\t%d,\n' % width)
+            out.write('\t\t\t\t{\n')
+            for row in range(0, len(pixmap), max(width, 1)):
+                out.write('\t\t\t\t\t%s,\n' %
+                          ','.join(str(v) for v in pixmap[row:row + width]))
+            out.write('\t\t\t\t}\n')
+            out.write('\t\t\t},\n')
+        out.write('\t\t},\n')
+        out.write('\t\t%d\n' % (fallback if fallback in font['glyphs'] else 0))
+        out.write('\t},\n')
+    out.write('};\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('fonts', help='input font file (e.g. mali-gui/fonts/autogen.h)')
+    parser.add_argument('--source', action='append', default=[],
+                        help='C++ source to scan for UI strings (repeatable)')
+    parser.add_argument('--manifest', action='append', default=[],
+                        help='glyph manifest file (repeatable)')
+    parser.add_argument('--fallback', default='?',
+                        help='glyph drawn for characters missing in the subset')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    fonts = parse_fonts(open(args.fonts, encoding='utf-8').read())
+    if not fonts:
+        sys.exit('%s: no fonts found' % args.fonts)
+
+    needed = {}
+    common = set()
+    for path in args.source:
+        common.update(scan_source(path, needed))
+    for path in args.manifest:
+        read_manifest(path, needed, common)
+
+    fallback = ord(unescape(args.fallback)[0]) if args.fallback else 0
+
+    # The first font is always kept, as FontDatabase returns it for unknown
+    # fonts, together with all glyphs requested from such fonts.
+    available = {(f['name'], f['size']) for f in fonts}
+    wanted = {(fonts[0]['name'], fonts[0]['size']): set()}
+    for key, glyphs in needed.items():
+        if key not in available:
+            key = (fonts[0]['name'], fonts[0]['size'])
+        wanted.setdefault(key, set()).update(glyphs)
+
+    subset = []
+    for font in fonts:
+        key = (font['name'], font['size'])
+        if key not in wanted:
+            continue
+        codes = {ord(g) for g in wanted[key] | common} | {fallback}
+        font['glyphs'] = {c: g for c, g in font['glyphs'].items() if c in codes}
+        subset.append(font)
+
+    out = open(args.output, 'w', encoding='utf-8') if args.output else sys.stdout
+    emit(subset, fallback, out)
+
+
+if __name__ == '__main__':
+    main()